@@ -0,0 +1,66 @@
+#include "AIScheduler.h"
+#include "PerfStats.h"
+
+// By AIType. 12 steps is 5 Hz at our 60 Hz step; near is a little past where a guard wakes up
+static const AIScheduler::Rate rates[] = {
+    //  near    near far
+    //  distance     interval
+    {   8.0f,   1,   12 },  // WALKER
+    {   8.0f,   1,   12 },  // GUARD
+    {   8.0f,   1,   12 },  // ASTEROID
+    {   8.0f,   1,    6 },  // ALIEN
+    {   8.0f,   1,    4 },  // BIG_ALIEN
+};
+
+const AIScheduler::Rate &AIScheduler::get_rate(AIType ai_type)
+{
+    return rates[ai_type];
+}
+
+void AIScheduler::begin_step()
+{
+    step++;
+    budget_left = budget;
+}
+
+void AIScheduler::schedule(Entity *const *batch, int count, AIType ai_type, Entity *player)
+{
+    if (count == 0) return;
+
+    const Rate &rate = get_rate(ai_type);
+    float near_distance_squared = rate.near_distance * rate.near_distance;
+
+    EntityStore &store = Entity::store;
+    float player_x = store.position_x[player->get_slot()], player_y = store.position_y[player->get_slot()];
+
+    int ticks = 0, deferred = 0;
+    int start = step % count;
+    for (int k = 0; k < count; k++)
+    {
+        Entity *entity = batch[(start + k) % count];
+        int slot = entity->get_slot();
+
+        // Step 1: Is it our turn?
+        float x_distance = store.position_x[slot] - player_x;
+        float y_distance = store.position_y[slot] - player_y;
+        bool is_near = x_distance * x_distance + y_distance * y_distance < near_distance_squared;
+
+        int interval = is_near ? rate.near_interval : rate.far_interval;
+        bool is_due = (slot + step) % interval == 0;
+
+        // Step 2: Can we afford it? Near ones always can, but still use up the budget
+        if (is_due)
+        {
+            if (budget_left > 0) budget_left--;
+            else if (!is_near) {
+                is_due = false;
+                deferred++;
+            }
+        }
+
+        if (is_due) ticks++;
+        entity->set_skipping_ai(!is_due);
+    }
+
+    PerfStats::count_ai(ticks, deferred);
+}
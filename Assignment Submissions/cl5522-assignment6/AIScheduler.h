@@ -0,0 +1,51 @@
+#pragma once
+#include "Entity.h"
+
+/**
+ * Decides which enemies run their AI on each fixed step, so AI costs about
+ * the same however many enemies there are.
+ *
+ * Every AIType has its own tick rates, one for enemies near the player and
+ * one for the rest (e.g. every step up close, every 12th step - 5 Hz - far
+ * away). Enemies on the same rate are spread over its steps by store slot,
+ * round robin, so a slow rate thins out the work instead of bunching it up.
+ *
+ * On top of that every step has a budget of AI ticks. Near enemies always
+ * get theirs; far ones take what is left and, once it runs out, wait for
+ * their next turn. Where each step's scan starts moves along every step, so
+ * it isn't always the same ones that miss out.
+ *
+ * Everything here is worked out from the step number, never from how long
+ * things took, so the same inputs always pick the same enemies and replays
+ * and snapshots stay exact.
+ */
+class AIScheduler {
+public:
+    struct Rate
+    {
+        float near_distance; // how close counts as near
+        int near_interval;   // steps between ticks when near...
+        int far_interval;    // ...and when not
+    };
+
+    static const int DEFAULT_BUDGET = 64; // AI ticks per step
+
+    // Counts the step and refills the budget
+    void begin_step();
+
+    // Marks which of `batch` (all of `ai_type`) skip their AI this step
+    void schedule(Entity *const *batch, int count, AIType ai_type, Entity *player);
+
+    static const Rate &get_rate(AIType ai_type);
+
+    void set_budget(int new_budget) { budget = new_budget; };
+    void set_step(int new_step)     { step = new_step; };
+
+    int const get_step()   const { return step; };
+    int const get_budget() const { return budget; };
+
+private:
+    int step   = 0;
+    int budget = DEFAULT_BUDGET;
+    int budget_left = 0;
+};
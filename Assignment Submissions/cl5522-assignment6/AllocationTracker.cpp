@@ -0,0 +1,235 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include <SDL.h>
+#include "AllocationTracker.h"
+
+static const char *subsystem_names[AllocationTracker::MAX_SUBSYSTEMS] = { "other" };
+static int subsystem_count   = 1;
+static int current_subsystem = 0;
+
+static AllocationTracker::Counts frame_counts[AllocationTracker::MAX_SUBSYSTEMS];
+static AllocationTracker::Counts last_frame_counts[AllocationTracker::MAX_SUBSYSTEMS];
+static AllocationTracker::Counts total_counts[AllocationTracker::MAX_SUBSYSTEMS];
+static int free_count = 0;
+
+static thread_local bool is_ignored_thread = false;
+static thread_local bool is_sdl_thread     = false; // the one that called hook_sdl()
+
+bool const AllocationTracker::is_enabled()
+{
+#ifdef TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocationTracker::record_allocation(size_t size)
+{
+    if (is_ignored_thread) return;
+
+    frame_counts[current_subsystem].allocations++;
+    frame_counts[current_subsystem].bytes += size;
+    total_counts[current_subsystem].allocations++;
+    total_counts[current_subsystem].bytes += size;
+}
+
+void AllocationTracker::record_free()
+{
+    if (is_ignored_thread) return;
+
+    free_count++;
+}
+
+void AllocationTracker::ignore_this_thread()
+{
+    is_ignored_thread = true;
+}
+
+void AllocationTracker::begin_frame()
+{
+    memset(frame_counts, 0, sizeof(frame_counts));
+}
+
+void AllocationTracker::end_frame()
+{
+    memcpy(last_frame_counts, frame_counts, sizeof(frame_counts));
+}
+
+int AllocationTracker::push_subsystem(const char *name)
+{
+    int previous = current_subsystem;
+
+    // Step 1: Look the name up...
+    int subsystem = 0;
+    while (subsystem < subsystem_count && strcmp(subsystem_names[subsystem], name) != 0) subsystem++;
+
+    // Step 2: ...or give it a row, if there is one left
+    if (subsystem == subsystem_count)
+    {
+        if (subsystem_count == MAX_SUBSYSTEMS) return previous;
+        subsystem_names[subsystem_count++] = name;
+    }
+
+    current_subsystem = subsystem;
+    return previous;
+}
+
+void AllocationTracker::pop_subsystem(int previous)
+{
+    current_subsystem = previous;
+}
+
+AllocationTracker::Counts const AllocationTracker::get_frame()
+{
+    Counts counts = { 0, 0 };
+    for (int i = 0; i < subsystem_count; i++)
+    {
+        counts.allocations += last_frame_counts[i].allocations;
+        counts.bytes       += last_frame_counts[i].bytes;
+    }
+    return counts;
+}
+
+AllocationTracker::Counts const AllocationTracker::get_frame(int subsystem) { return last_frame_counts[subsystem]; }
+AllocationTracker::Counts const AllocationTracker::get_total(int subsystem) { return total_counts[subsystem]; }
+int const AllocationTracker::get_frees()                                   { return free_count; }
+int const AllocationTracker::get_subsystem_count()                         { return subsystem_count; }
+const char * const AllocationTracker::get_subsystem_name(int subsystem)    { return subsystem_names[subsystem]; }
+
+void AllocationTracker::print_frame(FILE *file)
+{
+    for (int i = 0; i < subsystem_count; i++)
+    {
+        if (last_frame_counts[i].allocations == 0) continue;
+        fprintf(file, "    %-12s %d allocations, %zu bytes\n", subsystem_names[i],
+                last_frame_counts[i].allocations, last_frame_counts[i].bytes);
+    }
+}
+
+/**
+ MALLOC
+ */
+void *AllocationTracker::allocate(size_t size)
+{
+#ifdef TRACK_ALLOCATIONS
+    record_allocation(size);
+#endif
+    return malloc(size);
+}
+
+void *AllocationTracker::allocate_zeroed(size_t count, size_t size)
+{
+#ifdef TRACK_ALLOCATIONS
+    record_allocation(count * size);
+#endif
+    return calloc(count, size);
+}
+
+void *AllocationTracker::reallocate(void *pointer, size_t size)
+{
+#ifdef TRACK_ALLOCATIONS
+    // It may well move, so it counts as freeing the old block and allocating a new one
+    if (pointer != NULL) record_free();
+    record_allocation(size);
+#endif
+    return realloc(pointer, size);
+}
+
+void AllocationTracker::release(void *pointer)
+{
+#ifdef TRACK_ALLOCATIONS
+    if (pointer != NULL) record_free();
+#endif
+    free(pointer);
+}
+
+void *AllocationTracker::allocate_aligned(size_t size, size_t alignment)
+{
+    // Room to line it up, plus malloc's own pointer kept just in front, for release_aligned()
+    unsigned char *block = (unsigned char*) allocate(size + alignment - 1 + sizeof(void*));
+    if (block == NULL) return NULL;
+
+    uintptr_t aligned = ((uintptr_t) (block + sizeof(void*)) + alignment - 1) & ~(uintptr_t) (alignment - 1);
+    ((void**) aligned)[-1] = block;
+    return (void*) aligned;
+}
+
+void AllocationTracker::release_aligned(void *pointer)
+{
+    if (pointer != NULL) release(((void**) pointer)[-1]);
+}
+
+// What SDL gets: the same, but other threads of SDL's (audio) aren't counted
+static void *SDLCALL sdl_malloc(size_t size)
+{
+    return is_sdl_thread ? AllocationTracker::allocate(size) : malloc(size);
+}
+
+static void *SDLCALL sdl_calloc(size_t count, size_t size)
+{
+    return is_sdl_thread ? AllocationTracker::allocate_zeroed(count, size) : calloc(count, size);
+}
+
+static void *SDLCALL sdl_realloc(void *pointer, size_t size)
+{
+    return is_sdl_thread ? AllocationTracker::reallocate(pointer, size) : realloc(pointer, size);
+}
+
+static void SDLCALL sdl_free(void *pointer)
+{
+    if (is_sdl_thread) AllocationTracker::release(pointer);
+    else free(pointer);
+}
+
+void AllocationTracker::hook_sdl()
+{
+#ifdef TRACK_ALLOCATIONS
+    is_sdl_thread = true;
+    SDL_SetMemoryFunctions(sdl_malloc, sdl_calloc, sdl_realloc, sdl_free);
+#endif
+}
+
+/**
+ HOOKS
+ */
+#ifdef TRACK_ALLOCATIONS
+static void *tracked_allocate(size_t size)
+{
+    AllocationTracker::record_allocation(size);
+    return malloc(size == 0 ? 1 : size);
+}
+
+static void tracked_free(void *pointer)
+{
+    if (pointer == NULL) return;
+    AllocationTracker::record_free();
+    free(pointer);
+}
+
+void *operator new(size_t size)
+{
+    void *pointer = tracked_allocate(size);
+    if (pointer == NULL) throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new[](size_t size)
+{
+    void *pointer = tracked_allocate(size);
+    if (pointer == NULL) throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept   { return tracked_allocate(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return tracked_allocate(size); }
+
+void operator delete(void *pointer) noexcept                          { tracked_free(pointer); }
+void operator delete[](void *pointer) noexcept                        { tracked_free(pointer); }
+void operator delete(void *pointer, size_t) noexcept                  { tracked_free(pointer); }
+void operator delete[](void *pointer, size_t) noexcept                { tracked_free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept   { tracked_free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { tracked_free(pointer); }
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+ * Counts heap allocations, per frame and per subsystem.
+ *
+ * Opt-in: the global operator new/delete are only replaced when the project
+ * is built with TRACK_ALLOCATIONS defined. Otherwise every count stays at
+ * zero and is_enabled() says so.
+ *
+ * malloc can't be replaced the same way everywhere, so memory that doesn't
+ * come from new is asked for through allocate() and friends instead: the
+ * arenas' blocks, the behaviour pool, the SIMD stores and stb_image all do,
+ * and hook_sdl() hands them to SDL. Anything still calling malloc directly
+ * isn't seen.
+ *
+ * Allocations are charged to the innermost AllocationScope ("simulation",
+ * "render"...), or to "other" outside of any. The tracker itself never
+ * allocates: subsystems live in a fixed table.
+ *
+ * The counters aren't shared safely between threads, so worker threads
+ * (see PathService) call ignore_this_thread() first and aren't counted.
+ */
+class AllocationTracker {
+public:
+    static const int MAX_SUBSYSTEMS = 16;
+
+    struct Counts
+    {
+        int allocations;
+        size_t bytes;
+    };
+
+    static bool const is_enabled();
+
+    // Called by the operator new/delete hooks
+    static void record_allocation(size_t size);
+    static void record_free();
+
+    // malloc, calloc, realloc and free, counted when tracking is built in
+    static void *allocate(size_t size);
+    static void *allocate_zeroed(size_t count, size_t size);
+    static void *reallocate(void *pointer, size_t size);
+    static void  release(void *pointer);
+
+    // For SIMD arrays; alignment is a power of two. Only release_aligned() may free them
+    static void *allocate_aligned(size_t size, size_t alignment);
+    static void  release_aligned(void *pointer);
+
+    // Routes SDL's allocations through the above. Before SDL_Init(); only what SDL
+    // allocates on this thread is counted, not its audio thread's
+    static void hook_sdl();
+
+    // Stops counting whatever this thread allocates or frees
+    static void ignore_this_thread();
+
+    static void begin_frame();
+    static void end_frame();
+
+    // Returns the subsystem that was current before, to hand back to pop_subsystem()
+    static int  push_subsystem(const char *name);
+    static void pop_subsystem(int previous);
+
+    // Counts for the last finished frame, and since startup
+    static Counts const get_frame();
+    static Counts const get_frame(int subsystem);
+    static Counts const get_total(int subsystem);
+    static int    const get_frees();
+
+    static int          const get_subsystem_count();
+    static const char * const get_subsystem_name(int subsystem);
+
+    static void print_frame(FILE *file);
+};
+
+// Charges everything allocated while it is alive to one subsystem
+class AllocationScope {
+private:
+    int previous;
+
+public:
+    AllocationScope(const char *name) { previous = AllocationTracker::push_subsystem(name); };
+    ~AllocationScope() { AllocationTracker::pop_subsystem(previous); };
+};
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include "Arena.h"
+#include "AllocationTracker.h"
+
+// Leaves room for the block header, rounded so allocations start 16-byte aligned
+#define BLOCK_HEADER ((sizeof(Block) + 15) & ~(size_t) 15)
+
+Arena::Arena(size_t block_size)
+{
+    this->block_size = block_size;
+    first = current = new_block(block_size);
+}
+
+Arena::~Arena()
+{
+    reset();
+    AllocationTracker::release(first);
+}
+
+Arena::Block *Arena::new_block(size_t capacity)
+{
+    Block *block = (Block*) AllocationTracker::allocate(BLOCK_HEADER + capacity);
+    block->next     = NULL;
+    block->capacity = capacity;
+    block->used     = 0;
+    return block;
+}
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+    // Step 1: Line the offset up
+    size_t offset = (current->used + alignment - 1) & ~(alignment - 1);
+
+    // Step 2: Chain on another block if this one is out of room
+    if (offset + size > current->capacity)
+    {
+        Block *block = new_block(size + alignment > block_size ? size + alignment : block_size);
+        current->next = block;
+        current = block;
+        offset = 0;
+    }
+
+    current->used = offset + size;
+    allocation_count++;
+
+    return (unsigned char*) current + BLOCK_HEADER + offset;
+}
+
+void Arena::reset()
+{
+    // Step 1: Destroy objects in the opposite order they were made
+    for (Finalizer *finalizer = finalizers; finalizer != NULL; finalizer = finalizer->next)
+    {
+        finalizer->destroy(finalizer->objects, finalizer->count);
+    }
+    finalizers = NULL;
+
+    size_t used = get_used();
+    if (used > peak_used) peak_used = used;
+
+    // Step 2: Give back the overflow blocks and start over
+    Block *block = first->next;
+    while (block != NULL)
+    {
+        Block *next = block->next;
+        AllocationTracker::release(block);
+        block = next;
+    }
+
+    first->next = NULL;
+    first->used = 0;
+    current = first;
+    allocation_count = 0;
+}
+
+size_t const Arena::get_used() const
+{
+    size_t used = 0;
+    for (Block *block = first; block != NULL; block = block->next) used += block->used;
+    return used;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+
+/**
+ * A bump allocator for things that all die at the same time: a scene's
+ * entities, or the scratch buffers of a single frame.
+ *
+ * Allocating just moves an offset forward inside one big block. reset()
+ * runs the destructors of whatever needs them (newest first) and moves the
+ * offset back to the start, so nothing is ever freed piecemeal. If a block
+ * fills up, another one is chained on; reset() hands those back and keeps
+ * only the first.
+ */
+class Arena {
+private:
+    struct Block
+    {
+        Block *next;
+        size_t capacity;
+        size_t used;
+    };
+
+    // Kept inside the arena itself, one per object (or array) with a destructor
+    struct Finalizer
+    {
+        void (*destroy)(void *objects, int count);
+        void *objects;
+        int count;
+        Finalizer *next;
+    };
+
+    Block *first;
+    Block *current;
+    size_t block_size;
+    Finalizer *finalizers = NULL;
+
+    int allocation_count = 0;
+    size_t peak_used = 0;
+
+    template <typename T>
+    static void destroy_objects(void *objects, int count)
+    {
+        T *typed = (T*) objects;
+        for (int i = count - 1; i >= 0; i--) typed[i].~T();
+    }
+
+    template <typename T>
+    void add_finalizer(T *objects, int count)
+    {
+        if (std::is_trivially_destructible<T>::value) return;
+
+        Finalizer *finalizer = (Finalizer*) allocate(sizeof(Finalizer), alignof(Finalizer));
+        finalizer->destroy = &destroy_objects<T>;
+        finalizer->objects = objects;
+        finalizer->count   = count;
+        finalizer->next    = finalizers;
+        finalizers = finalizer;
+    }
+
+    Block *new_block(size_t capacity);
+
+public:
+    Arena(size_t block_size);
+    ~Arena();
+
+    // Arenas own raw memory, so copying one would free it twice
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t size, size_t alignment = 16);
+    void reset();
+
+    template <typename T, typename... Args>
+    T *create(Args&&... args)
+    {
+        T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        add_finalizer(object, 1);
+        return object;
+    }
+
+    template <typename T>
+    T *create_array(int count)
+    {
+        T *objects = (T*) allocate(sizeof(T) * count, alignof(T));
+        for (int i = 0; i < count; i++) new (&objects[i]) T();
+        add_finalizer(objects, count);
+        return objects;
+    }
+
+    template <typename T>
+    T *copy_array(std::initializer_list<T> values)
+    {
+        T *objects = (T*) allocate(sizeof(T) * values.size(), alignof(T));
+        int i = 0;
+        for (const T &value : values) new (&objects[i++]) T(value);
+        add_finalizer(objects, (int) values.size());
+        return objects;
+    }
+
+    size_t const get_used()             const;
+    size_t const get_peak_used()        const { return peak_used; }; // as of the last reset()
+    int    const get_allocation_count() const { return allocation_count; };
+};
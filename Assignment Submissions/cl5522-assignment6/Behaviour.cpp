@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <new>
+#include "Behaviour.h"
+#include "Entity.h"
+#include "VisibilityCache.h"
+#include "AllocationTracker.h"
+
+/**
+ POOL
+ */
+BehaviourPool::FreeBlock *BehaviourPool::free_blocks = NULL;
+int BehaviourPool::blocks_in_use   = 0;
+int BehaviourPool::chunk_count     = 0;
+int BehaviourPool::oversized_count = 0;
+
+void *BehaviourPool::allocate(size_t size)
+{
+    if (size > BLOCK_SIZE)
+    {
+        oversized_count++;
+        return ::operator new(size);
+    }
+
+    // Out of blocks: cut up a new chunk
+    if (free_blocks == NULL)
+    {
+        unsigned char *chunk = (unsigned char*) AllocationTracker::allocate(BLOCK_SIZE * BLOCKS_PER_CHUNK);
+        if (chunk == NULL) throw std::bad_alloc();
+        chunk_count++;
+
+        for (int i = BLOCKS_PER_CHUNK - 1; i >= 0; i--)
+        {
+            FreeBlock *block = (FreeBlock*) (chunk + BLOCK_SIZE * i);
+            block->next = free_blocks;
+            free_blocks = block;
+        }
+    }
+
+    FreeBlock *block = free_blocks;
+    free_blocks = block->next;
+    blocks_in_use++;
+    return block;
+}
+
+void BehaviourPool::release(void *frame, size_t size)
+{
+    if (size > BLOCK_SIZE)
+    {
+        ::operator delete(frame);
+        return;
+    }
+
+    FreeBlock *block = (FreeBlock*) frame;
+    block->next = free_blocks;
+    free_blocks = block;
+    blocks_in_use--;
+}
+
+/**
+ BEHAVIOUR
+ */
+static float distance_squared(Entity *self, Entity *player)
+{
+    glm::vec3 offset = self->get_position() - player->get_position();
+    return offset.x * offset.x + offset.y * offset.y;
+}
+
+Behaviour &Behaviour::operator=(Behaviour &&other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+void Behaviour::reset()
+{
+    if (handle) handle.destroy();
+    handle = nullptr;
+}
+
+void Behaviour::tick(Entity *self, Entity *player, float delta_time, VisibilityCache *visibility)
+{
+    if (!handle || handle.done()) return;
+
+    // Step 1: Has what we're waiting on happened yet?
+    Behaviour::promise_type &promise = handle.promise();
+    const BehaviourWait &wait = promise.wait;
+    promise.waited += delta_time;
+
+    switch (wait.kind)
+    {
+        case BehaviourWait::SECONDS:
+            if (promise.waited < wait.value) return;
+            break;
+
+        case BehaviourWait::PLAYER_WITHIN:
+            if (distance_squared(self, player) >= wait.value * wait.value) return;
+            break;
+
+        case BehaviourWait::PLAYER_BEYOND:
+            if (distance_squared(self, player) <= wait.value * wait.value) return;
+            break;
+
+        // Distance first: it's cheap, and most of the time it's enough to say no
+        case BehaviourWait::PLAYER_IN_SIGHT:
+            if (distance_squared(self, player) >= wait.value * wait.value) return;
+            if (visibility != NULL && !visibility->can_see(self->get_position())) return;
+            break;
+
+        default:
+            break;
+    }
+
+    // Step 2: Then carry on to the next co_await
+    handle.resume();
+}
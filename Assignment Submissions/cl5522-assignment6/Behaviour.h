@@ -0,0 +1,132 @@
+#pragma once
+#include <stddef.h>
+#include <coroutine>
+
+class Entity;
+class VisibilityCache;
+
+/**
+ * Hands out the memory for behaviour coroutine frames.
+ *
+ * Frames are all about the same size and come and go as enemies are
+ * restarted, so they are kept in BLOCK_SIZE blocks on a free list, carved
+ * out of chunks of BLOCKS_PER_CHUNK that are only given back when the
+ * program ends. A frame too big for a block (a script with a lot of locals)
+ * goes to the heap instead and is counted, so it shows up.
+ *
+ * Like the rest of the simulation, this is only used from the main thread.
+ */
+class BehaviourPool {
+public:
+    static const size_t BLOCK_SIZE       = 256;
+    static const int    BLOCKS_PER_CHUNK = 64;
+
+    static void *allocate(size_t size);
+    static void  release(void *frame, size_t size);
+
+    static int const get_blocks_in_use()  { return blocks_in_use; };
+    static int const get_chunk_count()    { return chunk_count; };
+    static int const get_oversized_count() { return oversized_count; };
+
+private:
+    struct FreeBlock { FreeBlock *next; };
+
+    static FreeBlock *free_blocks;
+    static int blocks_in_use;
+    static int chunk_count;
+    static int oversized_count;
+};
+
+// What a suspended behaviour is waiting on. It is checked without resuming
+// the script, so a behaviour that is waiting costs a compare per step
+struct BehaviourWait
+{
+    enum Kind { NEXT_STEP, SECONDS, PLAYER_WITHIN, PLAYER_BEYOND, PLAYER_IN_SIGHT };
+
+    Kind kind;
+    float value; // seconds, or a distance
+};
+
+/**
+ * A script for one entity, written as a C++20 coroutine that co_awaits
+ * the things below between moves, e.g.
+ *
+ *     Behaviour sentry(Entity *self, Entity *player)
+ *     {
+ *         co_await player_within(6.0f);
+ *         self->set_movement(...);
+ *         co_await seconds(3.0f);
+ *         ...
+ *     }
+ *
+ * Nothing runs until the first tick(). Each tick() resumes the script only
+ * if what it is waiting on has happened; the script then runs up to its
+ * next co_await. Once it returns, ticking it does nothing. Every co_await
+ * gives back the seconds it waited, so a script can keep time itself:
+ *
+ *     for (float t = 0.0f; t < 3.0f; t += co_await next_step()) ...
+ */
+class Behaviour {
+public:
+    struct promise_type
+    {
+        BehaviourWait wait = { BehaviourWait::NEXT_STEP, 0.0f };
+        float waited = 0.0f; // seconds since the last co_await
+
+        Behaviour get_return_object() { return Behaviour(std::coroutine_handle<promise_type>::from_promise(*this)); };
+        std::suspend_always initial_suspend() noexcept { return {}; };
+        std::suspend_always final_suspend()   noexcept { return {}; };
+        void return_void() {};
+        void unhandled_exception() { throw; };
+
+        static void *operator new(size_t size)             { return BehaviourPool::allocate(size); };
+        static void  operator delete(void *frame, size_t size) { BehaviourPool::release(frame, size); };
+    };
+
+    Behaviour() {};
+    ~Behaviour() { reset(); };
+
+    // Owns its coroutine frame, so it can only be moved
+    Behaviour(Behaviour &&other) noexcept : handle(other.handle) { other.handle = nullptr; };
+    Behaviour &operator=(Behaviour &&other) noexcept;
+    Behaviour(const Behaviour &) = delete;
+    Behaviour &operator=(const Behaviour &) = delete;
+
+    // delta_time: how long since the last tick. Without a visibility cache nothing blocks the view
+    void tick(Entity *self, Entity *player, float delta_time, VisibilityCache *visibility = NULL);
+
+    // Throws the script away; the next one starts from the top
+    void reset();
+
+    bool const is_started() const { return (bool) handle; };
+    bool const is_done()    const { return handle && handle.done(); };
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Behaviour(std::coroutine_handle<promise_type> new_handle) : handle(new_handle) {};
+};
+
+// co_await one of these to wait on it
+struct BehaviourAwaiter
+{
+    BehaviourWait wait;
+    Behaviour::promise_type *promise = NULL;
+
+    bool await_ready() const noexcept { return false; };
+    void await_suspend(std::coroutine_handle<Behaviour::promise_type> handle) noexcept
+    {
+        promise = &handle.promise();
+        promise->wait   = wait;
+        promise->waited = 0.0f;
+    };
+    float await_resume() const noexcept { return promise->waited; };
+};
+
+inline BehaviourAwaiter next_step()                   { return { { BehaviourWait::NEXT_STEP,     0.0f     } }; }
+inline BehaviourAwaiter seconds(float duration)       { return { { BehaviourWait::SECONDS,       duration } }; }
+inline BehaviourAwaiter player_within(float distance) { return { { BehaviourWait::PLAYER_WITHIN, distance } }; }
+inline BehaviourAwaiter player_beyond(float distance) { return { { BehaviourWait::PLAYER_BEYOND, distance } }; }
+
+// Within distance, with no wall in between
+inline BehaviourAwaiter player_in_sight(float distance) { return { { BehaviourWait::PLAYER_IN_SIGHT, distance } }; }
@@ -0,0 +1,479 @@
+#include <stdlib.h>
+#include <float.h>
+#include <algorithm>
+#include <functional>
+#include "ClusterGraph.h"
+
+#define DIAGONAL_COST 1.41421356f
+#define NO_PATH FLT_MAX
+
+// The graph search leans on its estimate this much harder than a true A* would. Paths come
+// out a few percent longer (HPA*'s are never the shortest anyway) but it looks at a fraction
+// of the nodes, since many routes through a cluster cost nearly the same
+#define GRAPH_ESTIMATE_WEIGHT 1.25f
+
+// Eight ways out of a tile: the four straight ones first
+static const int STEP_X[] = { 1, -1, 0,  0, 1,  1, -1, -1 };
+static const int STEP_Y[] = { 0,  0, 1, -1, 1, -1,  1, -1 };
+
+// The cheapest possible walk between two tiles, with diagonal steps allowed
+static float estimate(TilePosition a, TilePosition b)
+{
+    int dx = abs(a.x - b.x), dy = abs(a.y - b.y);
+    return (float) (dx + dy) + (DIAGONAL_COST - 2.0f) * (float) std::min(dx, dy);
+}
+
+static bool same_tile(TilePosition a, TilePosition b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+typedef std::greater<std::pair<float, int> > MinFirst;
+
+/**
+ BUILDING
+ */
+ClusterGraph::ClusterGraph(const Map *map)
+{
+    this->map = map;
+    width  = map->get_width();
+    height = map->get_height();
+    clusters_x = (width  + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    clusters_y = (height + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+    walkable.resize(width * height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++) walkable[y * width + x] = map->is_walkable(x, y);
+    }
+
+    int cluster_count = get_cluster_count();
+    cluster_nodes.resize(cluster_count);
+    border_nodes[EAST].resize(cluster_count);
+    border_nodes[SOUTH].resize(cluster_count);
+
+    // Step 1: The ways between clusters...
+    for (int cluster = 0; cluster < cluster_count; cluster++)
+    {
+        build_border(cluster, EAST);
+        build_border(cluster, SOUTH);
+    }
+
+    // Step 2: ...and the ways across each one
+    for (int cluster = 0; cluster < cluster_count; cluster++) build_cluster_edges(cluster);
+}
+
+ClusterGraph::Rect const ClusterGraph::get_rect(int cluster) const
+{
+    Rect rect;
+    rect.x0 = (cluster % clusters_x) * CLUSTER_SIZE;
+    rect.y0 = (cluster / clusters_x) * CLUSTER_SIZE;
+    rect.x1 = std::min(rect.x0 + CLUSTER_SIZE, width);
+    rect.y1 = std::min(rect.y0 + CLUSTER_SIZE, height);
+    return rect;
+}
+
+int ClusterGraph::add_node(int x, int y)
+{
+    int node;
+    if (!free_nodes.empty())
+    {
+        node = free_nodes.back();
+        free_nodes.pop_back();
+    }
+    else
+    {
+        node = (int) nodes.size();
+        nodes.push_back(Node());
+    }
+
+    nodes[node].tile.x  = x;
+    nodes[node].tile.y  = y;
+    nodes[node].cluster = get_cluster(x, y);
+    nodes[node].edges.clear();
+    cluster_nodes[nodes[node].cluster].push_back(node);
+    return node;
+}
+
+void ClusterGraph::free_node(int node)
+{
+    std::vector<int> &list = cluster_nodes[nodes[node].cluster];
+    list.erase(std::find(list.begin(), list.end(), node));
+
+    nodes[node].cluster = -1;
+    nodes[node].edges.clear();
+    free_nodes.push_back(node);
+}
+
+void ClusterGraph::connect(int a, int b, float cost, bool is_step)
+{
+    nodes[a].edges.push_back({ b, cost, is_step });
+    nodes[b].edges.push_back({ a, cost, is_step });
+}
+
+// A node on each side of the border, `offset` tiles along it
+void ClusterGraph::add_entrance(int cluster, Border border, Rect rect, int offset)
+{
+    int inside, outside;
+    if (border == EAST) {
+        inside  = add_node(rect.x1 - 1, rect.y0 + offset);
+        outside = add_node(rect.x1,     rect.y0 + offset);
+    }
+    else {
+        inside  = add_node(rect.x0 + offset, rect.y1 - 1);
+        outside = add_node(rect.x0 + offset, rect.y1);
+    }
+
+    connect(inside, outside, 1.0f, true);
+    border_nodes[border][cluster].push_back(inside);
+    border_nodes[border][cluster].push_back(outside);
+}
+
+void ClusterGraph::build_border(int cluster, Border border)
+{
+    if (border == EAST  && cluster % clusters_x + 1 >= clusters_x) return;
+    if (border == SOUTH && cluster / clusters_x + 1 >= clusters_y) return;
+
+    Rect rect = get_rect(cluster);
+    int length = border == EAST ? rect.y1 - rect.y0 : rect.x1 - rect.x0;
+
+    // Every run of tiles open on both sides is one opening
+    int run_start = -1;
+    for (int i = 0; i <= length; i++)
+    {
+        bool is_opening = i < length && (border == EAST ? is_open(rect.x1 - 1, rect.y0 + i) && is_open(rect.x1, rect.y0 + i)
+                                                        : is_open(rect.x0 + i, rect.y1 - 1) && is_open(rect.x0 + i, rect.y1));
+        if (is_opening && run_start < 0) run_start = i;
+        if (is_opening || run_start < 0) continue;
+
+        int run_end = i - 1;
+        if (run_end - run_start + 1 > WIDE_ENTRANCE) {
+            add_entrance(cluster, border, rect, run_start);
+            add_entrance(cluster, border, rect, run_end);
+        }
+        else {
+            add_entrance(cluster, border, rect, (run_start + run_end) / 2);
+        }
+        run_start = -1;
+    }
+}
+
+void ClusterGraph::clear_border(int cluster, Border border)
+{
+    for (int node : border_nodes[border][cluster]) free_node(node);
+    border_nodes[border][cluster].clear();
+}
+
+void ClusterGraph::build_cluster_edges(int cluster)
+{
+    const std::vector<int> &list = cluster_nodes[cluster];
+    Rect rect = get_rect(cluster);
+
+    // Step 1: Forget the old ways across, keeping the steps over the borders
+    for (int node : list)
+    {
+        std::vector<Edge> &edges = nodes[node].edges;
+        edges.erase(std::remove_if(edges.begin(), edges.end(), [](const Edge &edge) { return !edge.is_step; }), edges.end());
+    }
+
+    // Step 2: Walk out from each node to every one after it
+    TilePosition everywhere = { -1, -1 };
+    for (size_t a = 0; a < list.size(); a++)
+    {
+        search_tiles(nodes[list[a]].tile, everywhere, rect, &build_search, NULL);
+
+        for (size_t b = a + 1; b < list.size(); b++)
+        {
+            float cost = get_tile_cost(nodes[list[b]].tile, rect, &build_search);
+            if (cost < NO_PATH) connect(list[a], list[b], cost, false);
+        }
+    }
+}
+
+/**
+ REPAIRING
+ */
+void ClusterGraph::mark_changed(int x, int y)
+{
+    TilePosition tile = { x, y };
+    changed_tiles.push_back(tile);
+}
+
+void ClusterGraph::repair()
+{
+    if (changed_tiles.empty()) return;
+
+    int cluster_count = get_cluster_count();
+    std::vector<char> is_border_dirty[BORDER_COUNT];
+    is_border_dirty[EAST].assign(cluster_count, 0);
+    is_border_dirty[SOUTH].assign(cluster_count, 0);
+    std::vector<char> is_cluster_dirty(cluster_count, 0);
+
+    // Step 1: Take the new tiles, and work out what they touch: always their own
+    //         cluster, and whichever borders (and clusters beyond) they sit on
+    for (TilePosition tile : changed_tiles)
+    {
+        walkable[tile.y * width + tile.x] = map->is_walkable(tile.x, tile.y);
+
+        int cluster = get_cluster(tile.x, tile.y);
+        Rect rect = get_rect(cluster);
+        is_cluster_dirty[cluster] = 1;
+
+        if (tile.x == rect.x1 - 1 && rect.x1 < width) {
+            is_border_dirty[EAST][cluster] = 1;
+            is_cluster_dirty[cluster + 1] = 1;
+        }
+        if (tile.x == rect.x0 && rect.x0 > 0) {
+            is_border_dirty[EAST][cluster - 1] = 1;
+            is_cluster_dirty[cluster - 1] = 1;
+        }
+        if (tile.y == rect.y1 - 1 && rect.y1 < height) {
+            is_border_dirty[SOUTH][cluster] = 1;
+            is_cluster_dirty[cluster + clusters_x] = 1;
+        }
+        if (tile.y == rect.y0 && rect.y0 > 0) {
+            is_border_dirty[SOUTH][cluster - clusters_x] = 1;
+            is_cluster_dirty[cluster - clusters_x] = 1;
+        }
+    }
+    changed_tiles.clear();
+
+    // Step 2: Redo those borders, then the ways across the clusters on either side
+    for (int border = 0; border < BORDER_COUNT; border++)
+    {
+        for (int cluster = 0; cluster < cluster_count; cluster++)
+        {
+            if (is_border_dirty[border][cluster]) clear_border(cluster, (Border) border);
+        }
+    }
+    for (int border = 0; border < BORDER_COUNT; border++)
+    {
+        for (int cluster = 0; cluster < cluster_count; cluster++)
+        {
+            if (is_border_dirty[border][cluster]) build_border(cluster, (Border) border);
+        }
+    }
+    for (int cluster = 0; cluster < cluster_count; cluster++)
+    {
+        if (is_cluster_dirty[cluster]) build_cluster_edges(cluster);
+    }
+}
+
+/**
+ SEARCHING
+ */
+float ClusterGraph::search_tiles(TilePosition from, TilePosition to, Rect rect, Search *search, std::vector<TilePosition> *path) const
+{
+    int rect_width = rect.x1 - rect.x0;
+    size_t size = (size_t) rect_width * (rect.y1 - rect.y0);
+    if (search->tile_cost.size() < size)
+    {
+        search->tile_cost.resize(size);
+        search->tile_parent.resize(size);
+        search->tile_stamp.resize(size, 0);
+    }
+
+    // Entries from earlier searches have older stamps, so nothing needs clearing
+    int generation = ++search->tile_generation;
+    bool has_goal = to.x >= 0;
+    std::vector<std::pair<float, int> > &open = search->open;
+    open.clear();
+
+    int start = (from.y - rect.y0) * rect_width + (from.x - rect.x0);
+    search->tile_cost[start]   = 0.0f;
+    search->tile_parent[start] = -1;
+    search->tile_stamp[start]  = generation;
+    open.push_back(std::make_pair(has_goal ? estimate(from, to) : 0.0f, start));
+
+    while (!open.empty())
+    {
+        std::pop_heap(open.begin(), open.end(), MinFirst());
+        std::pair<float, int> entry = open.back();
+        open.pop_back();
+
+        int index = entry.second;
+        TilePosition tile = { rect.x0 + index % rect_width, rect.y0 + index / rect_width };
+        float cost = search->tile_cost[index];
+
+        // Already reached more cheaply since this was queued
+        if (entry.first > cost + (has_goal ? estimate(tile, to) : 0.0f) + 0.001f) continue;
+        if (has_goal && same_tile(tile, to)) break;
+
+        for (int direction = 0; direction < 8; direction++)
+        {
+            TilePosition next = { tile.x + STEP_X[direction], tile.y + STEP_Y[direction] };
+            if (next.x < rect.x0 || next.x >= rect.x1 || next.y < rect.y0 || next.y >= rect.y1 || !is_open(next.x, next.y)) continue;
+
+            // No cutting corners: both tiles beside a diagonal step have to be open
+            bool is_diagonal = direction >= 4;
+            if (is_diagonal && (!is_open(next.x, tile.y) || !is_open(tile.x, next.y))) continue;
+
+            int next_index = (next.y - rect.y0) * rect_width + (next.x - rect.x0);
+            float next_cost = cost + (is_diagonal ? DIAGONAL_COST : 1.0f);
+            if (search->tile_stamp[next_index] == generation && search->tile_cost[next_index] <= next_cost) continue;
+
+            search->tile_cost[next_index]   = next_cost;
+            search->tile_parent[next_index] = index;
+            search->tile_stamp[next_index]  = generation;
+            open.push_back(std::make_pair(next_cost + (has_goal ? estimate(next, to) : 0.0f), next_index));
+            std::push_heap(open.begin(), open.end(), MinFirst());
+        }
+    }
+
+    if (!has_goal) return 0.0f;
+
+    float cost = get_tile_cost(to, rect, search);
+    if (cost == NO_PATH || path == NULL) return cost;
+
+    // Parents lead back to the start, so the tiles come out backwards
+    size_t first = path->size();
+    for (int index = (to.y - rect.y0) * rect_width + (to.x - rect.x0); index >= 0; index = search->tile_parent[index])
+    {
+        TilePosition tile = { rect.x0 + index % rect_width, rect.y0 + index / rect_width };
+        path->push_back(tile);
+    }
+    std::reverse(path->begin() + first, path->end());
+    return cost;
+}
+
+float const ClusterGraph::get_tile_cost(TilePosition tile, Rect rect, const Search *search) const
+{
+    int index = (tile.y - rect.y0) * (rect.x1 - rect.x0) + (tile.x - rect.x0);
+    return search->tile_stamp[index] == search->tile_generation ? search->tile_cost[index] : NO_PATH;
+}
+
+bool ClusterGraph::find_path(TilePosition start, TilePosition goal, Search *search, std::vector<TilePosition> *path, int max_expansions) const
+{
+    path->clear();
+    search->expansions = 0;
+    if (!is_open(start.x, start.y) || !is_open(goal.x, goal.y)) return false;
+
+    int start_cluster = get_cluster(start.x, start.y), goal_cluster = get_cluster(goal.x, goal.y);
+    Rect start_rect = get_rect(start_cluster), goal_rect = get_rect(goal_cluster);
+    TilePosition everywhere = { -1, -1 };
+
+    // Step 1: In the same cluster, try just walking there
+    if (start_cluster == goal_cluster && search_tiles(start, goal, start_rect, search, path) < NO_PATH) return true;
+    path->clear();
+
+    // Step 2: Hook the start and goal onto the graph, as two extra nodes at the end
+    const int node_count = (int) nodes.size(), START = node_count, GOAL = node_count + 1;
+    if ((int) search->node_cost.size() < node_count + 2)
+    {
+        search->node_cost.resize(node_count + 2);
+        search->node_parent.resize(node_count + 2);
+        search->node_stamp.resize(node_count + 2, 0);
+    }
+
+    search->start_edges.clear();
+    search_tiles(start, everywhere, start_rect, search, NULL);
+    for (int node : cluster_nodes[start_cluster])
+    {
+        float cost = get_tile_cost(nodes[node].tile, start_rect, search);
+        if (cost < NO_PATH) search->start_edges.push_back(std::make_pair(node, cost));
+    }
+
+    const std::vector<int> &goal_nodes = cluster_nodes[goal_cluster];
+    search->goal_costs.clear();
+    search_tiles(goal, everywhere, goal_rect, search, NULL);
+    for (int node : goal_nodes) search->goal_costs.push_back(get_tile_cost(nodes[node].tile, goal_rect, search));
+
+    // Step 3: A* over the graph
+    int generation = ++search->node_generation;
+    std::vector<std::pair<float, int> > &open = search->open;
+    open.clear();
+
+    search->node_cost[START]   = 0.0f;
+    search->node_parent[START] = -1;
+    search->node_stamp[START]  = generation;
+    open.push_back(std::make_pair(estimate(start, goal) * GRAPH_ESTIMATE_WEIGHT, START));
+
+    bool is_found = false;
+    while (!open.empty())
+    {
+        std::pop_heap(open.begin(), open.end(), MinFirst());
+        std::pair<float, int> entry = open.back();
+        open.pop_back();
+
+        int node = entry.second;
+        TilePosition tile = node == START ? start : nodes[node].tile;
+        float cost = search->node_cost[node];
+        if (entry.first > cost + estimate(tile, goal) * GRAPH_ESTIMATE_WEIGHT + 0.001f) continue;
+
+        if (node == GOAL) {
+            is_found = true;
+            break;
+        }
+        if (++search->expansions > max_expansions) return false;
+
+        // The start's ways out were found above; everyone else's are its edges, plus
+        // the last leg to the goal for the nodes in its cluster
+        int edge_count = node == START ? (int) search->start_edges.size() : (int) nodes[node].edges.size();
+        int extra = node != START && nodes[node].cluster == goal_cluster ? 1 : 0;
+
+        for (int i = 0; i < edge_count + extra; i++)
+        {
+            int next;
+            float step_cost;
+            if (i == edge_count) {
+                size_t position = std::find(goal_nodes.begin(), goal_nodes.end(), node) - goal_nodes.begin();
+                next = GOAL;
+                step_cost = search->goal_costs[position];
+                if (step_cost == NO_PATH) continue;
+            }
+            else if (node == START) {
+                next = search->start_edges[i].first;
+                step_cost = search->start_edges[i].second;
+            }
+            else {
+                next = nodes[node].edges[i].to;
+                step_cost = nodes[node].edges[i].cost;
+            }
+
+            float next_cost = cost + step_cost;
+            if (search->node_stamp[next] == generation && search->node_cost[next] <= next_cost) continue;
+
+            search->node_cost[next]   = next_cost;
+            search->node_parent[next] = node;
+            search->node_stamp[next]  = generation;
+            open.push_back(std::make_pair(next_cost + estimate(next == GOAL ? goal : nodes[next].tile, goal) * GRAPH_ESTIMATE_WEIGHT, next));
+            std::push_heap(open.begin(), open.end(), MinFirst());
+        }
+    }
+    if (!is_found) return false;
+
+    // Step 4: The nodes we went through, start first
+    search->node_path.clear();
+    for (int node = GOAL; node >= 0; node = search->node_parent[node]) search->node_path.push_back(node);
+    std::reverse(search->node_path.begin(), search->node_path.end());
+
+    // Step 5: Fill in the tiles: a step over a border is one tile, a way across a cluster is
+    //         walked again inside it
+    path->push_back(start);
+    for (size_t k = 1; k < search->node_path.size(); k++)
+    {
+        int a = search->node_path[k - 1], b = search->node_path[k];
+        TilePosition from = a == START ? start : nodes[a].tile;
+        TilePosition to   = b == GOAL  ? goal  : nodes[b].tile;
+
+        int from_cluster = get_cluster(from.x, from.y);
+        if (from_cluster != get_cluster(to.x, to.y)) {
+            path->push_back(to);
+            continue;
+        }
+
+        search->tile_path.clear();
+        search_tiles(from, to, get_rect(from_cluster), search, &search->tile_path);
+        path->insert(path->end(), search->tile_path.begin() + 1, search->tile_path.end());
+    }
+    return true;
+}
+
+bool ClusterGraph::find_path_flat(TilePosition start, TilePosition goal, Search *search, std::vector<TilePosition> *path) const
+{
+    path->clear();
+    if (!is_open(start.x, start.y) || !is_open(goal.x, goal.y)) return false;
+
+    Rect everything = { 0, 0, width, height };
+    return search_tiles(start, goal, everything, search, path) < NO_PATH;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <vector>
+#include "Map.h"
+
+struct TilePosition
+{
+    int x, y;
+};
+
+/**
+ * Hierarchical pathfinding (HPA*) over a Map.
+ *
+ * The map is cut into CLUSTER_SIZE x CLUSTER_SIZE clusters. Wherever two
+ * neighbouring clusters both have open tiles along their shared edge, the
+ * two tiles facing each other become a pair of nodes, one per cluster,
+ * joined by a step (one pair per opening, or one at each end of a wide
+ * one). Inside each cluster, every node is joined to every other node it
+ * can reach, at the cost of walking there. That small graph is what a path
+ * is searched over; the tile path is only filled in afterwards, one cluster
+ * at a time, so a path across a 1000x1000 map looks at a few hundred nodes
+ * rather than up to a million tiles.
+ *
+ * The graph keeps its own copy of which tiles are open. When a tile
+ * changes, mark_changed() notes it and repair() redoes just the edges of
+ * its cluster and the clusters that share them.
+ *
+ * find_path() only reads the graph, so any number of threads can search at
+ * once, each with its own Search; repair() must not run at the same time
+ * (PathService takes care of that).
+ */
+class ClusterGraph {
+public:
+    static const int CLUSTER_SIZE = 16;
+    static const int WIDE_ENTRANCE = 6; // openings wider than this get a node pair at each end
+
+    // Work space for one search; keep one per thread and reuse it
+    struct Search
+    {
+        // Tile searches inside one cluster
+        std::vector<float> tile_cost;
+        std::vector<int> tile_parent;
+        std::vector<int> tile_stamp;
+        int tile_generation = 0;
+
+        // Searches over the graph; the last two entries are the start and goal
+        std::vector<float> node_cost;
+        std::vector<int> node_parent;
+        std::vector<int> node_stamp;
+        int node_generation = 0;
+
+        std::vector<std::pair<float, int> > open;     // a min-heap on cost + estimate
+        std::vector<std::pair<int, float> > start_edges; // nodes the start can walk to, and the cost
+        std::vector<float> goal_costs;                  // by node in the goal's cluster
+
+        std::vector<int> node_path;
+        std::vector<TilePosition> tile_path;
+
+        int expansions = 0;
+    };
+
+    explicit ClusterGraph(const Map *map);
+
+    // Notes that the map's tile (x, y) has changed; nothing happens until repair()
+    void mark_changed(int x, int y);
+    void repair();
+
+    // Writes the tiles from start to goal, both included, into path. Fails if there is
+    // no way through, or if the graph search looks at more than max_expansions nodes
+    bool find_path(TilePosition start, TilePosition goal, Search *search, std::vector<TilePosition> *path, int max_expansions) const;
+
+    // A plain A* over the whole map, for comparison
+    bool find_path_flat(TilePosition start, TilePosition goal, Search *search, std::vector<TilePosition> *path) const;
+
+    int const get_node_count()    const { return (int) nodes.size() - (int) free_nodes.size(); };
+    int const get_cluster_count() const { return clusters_x * clusters_y; };
+
+private:
+    enum Border { EAST, SOUTH, BORDER_COUNT };
+
+    struct Edge
+    {
+        int to;
+        float cost;
+        bool is_step; // to the node across a border, rather than one in the same cluster
+    };
+
+    struct Node
+    {
+        TilePosition tile;
+        int cluster; // -1 once freed
+        std::vector<Edge> edges;
+    };
+
+    struct Rect
+    {
+        int x0, y0, x1, y1; // x1/y1 one past the end
+    };
+
+    const Map *map;
+    int width, height;
+    int clusters_x, clusters_y;
+    std::vector<unsigned char> walkable;
+
+    std::vector<Node> nodes;
+    std::vector<int> free_nodes;
+    std::vector<std::vector<int> > cluster_nodes;
+    std::vector<std::vector<int> > border_nodes[BORDER_COUNT]; // by the cluster to the west/north, both sides
+    std::vector<TilePosition> changed_tiles;
+
+    // For building, which only happens on the thread that owns the graph
+    Search build_search;
+
+    bool const is_open(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height && walkable[y * width + x]; };
+    int  const get_cluster(int x, int y) const { return (y / CLUSTER_SIZE) * clusters_x + x / CLUSTER_SIZE; };
+    Rect const get_rect(int cluster) const;
+
+    int  add_node(int x, int y);
+    void free_node(int node);
+    void connect(int a, int b, float cost, bool is_step);
+
+    void add_entrance(int cluster, Border border, Rect rect, int offset);
+    void build_border(int cluster, Border border);
+    void clear_border(int cluster, Border border);
+    void build_cluster_edges(int cluster);
+
+    // A* from `from` to `to` over the tiles in rect, or Dijkstra to all of them if to.x < 0.
+    // Leaves the costs in search; writes the path if asked for one
+    float search_tiles(TilePosition from, TilePosition to, Rect rect, Search *search, std::vector<TilePosition> *path) const;
+    float const get_tile_cost(TilePosition tile, Rect rect, const Search *search) const;
+};
@@ -0,0 +1,116 @@
+#include "ContactList.h"
+#include "Entity.h"
+
+/**
+ * Every pair of types that does anything when they touch, and what it does.
+ * Pairs that aren't here never make it past the broadphase: the entity's
+ * collision mask is built from its rows, see get_default_mask().
+ */
+static const struct
+{
+    EntityType type;
+    EntityType other_type;
+    PairResponse response;
+} pair_responses[] = {
+    //                            push   entity  other  spent
+    // Ramming an asteroid (or being rammed by one) costs the player a life
+    { PLAYER,      ENEMY,       { true,  1,      0,     false } },
+    { ENEMY,       PLAYER,      { true,  0,      1,     false } },
+    // A laser takes a life off whatever it hits, and is spent
+    { GREEN_LASER, ENEMY,       { true,  0,      1,     true  } },
+};
+
+#define PAIR_RESPONSE_COUNT (int) (sizeof(pair_responses) / sizeof(pair_responses[0]))
+
+const PairResponse *ContactList::get_response(int type, int other_type)
+{
+    for (int i = 0; i < PAIR_RESPONSE_COUNT; i++)
+    {
+        if (pair_responses[i].type == type && pair_responses[i].other_type == other_type) return &pair_responses[i].response;
+    }
+    return NULL;
+}
+
+unsigned int const ContactList::get_default_mask(int type)
+{
+    unsigned int mask = 0;
+    for (int i = 0; i < PAIR_RESPONSE_COUNT; i++)
+    {
+        if (pair_responses[i].type == type) mask |= 1u << pair_responses[i].other_type;
+    }
+    return mask;
+}
+
+void ContactList::reserve(int max_pairs)
+{
+    contacts.reserve(max_pairs);
+    damaged_pairs.reserve(max_pairs * 2);
+}
+
+void ContactList::begin_step()
+{
+    damaged_pairs.clear();
+}
+
+void ContactList::generate(Entity *const *batch, int count, Entity *collidables, int collidable_count, float sweep_time)
+{
+    contacts.clear();
+    if (collidable_count == 0) return;
+
+    if (sweep_time > 0.0f)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (batch[i]->get_updating_state()) batch[i]->find_swept_contact(collidables, collidable_count, sweep_time, &contacts);
+        }
+        return;
+    }
+
+    // The same collidables for the whole batch, so this only needs working out once
+    bool is_contiguous = Entity::has_contiguous_slots(collidables, collidable_count);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (batch[i]->get_updating_state()) batch[i]->find_contacts(collidables, collidable_count, is_contiguous, &contacts);
+    }
+}
+
+void ContactList::resolve()
+{
+    // Step 1: Response. Earlier pushes can clear later contacts, which resolve_contact() checks for
+    for (const Contact &contact : contacts)
+    {
+        const PairResponse *response = get_response(contact.entity->get_entity_type(), contact.other->get_entity_type());
+        if (response != NULL && response->push_out) contact.entity->resolve_contact(contact);
+    }
+
+    // Step 2: Damage, once per pair per step
+    for (const Contact &contact : contacts)
+    {
+        if (was_damaged(contact.entity, contact.other)) continue;
+
+        damaged_pairs.push_back(contact.entity);
+        damaged_pairs.push_back(contact.other);
+        damage(contact.entity, contact.other);
+    }
+}
+
+bool const ContactList::was_damaged(Entity *a, Entity *b) const
+{
+    for (size_t i = 0; i < damaged_pairs.size(); i += 2)
+    {
+        if ((damaged_pairs[i] == a && damaged_pairs[i + 1] == b) ||
+            (damaged_pairs[i] == b && damaged_pairs[i + 1] == a)) return true;
+    }
+    return false;
+}
+
+void ContactList::damage(Entity *entity, Entity *other)
+{
+    const PairResponse *response = get_response(entity->get_entity_type(), other->get_entity_type());
+    if (response == NULL) return;
+
+    if (response->entity_damage != 0) entity->set_lives(entity->get_lives() - response->entity_damage);
+    if (response->other_damage  != 0) other->set_lives(other->get_lives() - response->other_damage);
+    if (response->is_spent) entity->deactivate();
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include "glm/mat4x4.hpp"
+
+class Entity;
+
+struct Contact
+{
+    Entity *entity;    // the one that moved into the other
+    Entity *other;
+    float overlap_x;   // how deep in, along each axis
+    float overlap_y;
+    glm::vec3 normal;  // the way out for `entity`: along whichever axis it is in less deep
+
+    // Swept contacts only: how far along this step's move they first touched (0 to 1),
+    // and where `entity` was then. Plain overlaps have a time of 1
+    float time;
+    glm::vec3 impact;
+};
+
+// What happens when `entity` runs into `other`, by their types
+struct PairResponse
+{
+    bool push_out;     // `entity` is moved back out of `other`
+    int entity_damage; // lives each of them loses
+    int other_damage;
+    bool is_spent;     // `entity` deactivates
+};
+
+/**
+ * The narrowphase: every overlap found for a batch of entities after it
+ * has moved, found once per (sub)step and then used for both pushing the
+ * entities back out and dealing damage.
+ *
+ * A touch between two entities costs at most one life per step, however
+ * many of their updates find it (the player finds the asteroid, the
+ * asteroid finds the player...): pairs that have already been damaged
+ * this step are remembered until begin_step().
+ */
+class ContactList {
+private:
+    std::vector<Contact> contacts;
+    std::vector<Entity*> damaged_pairs; // two entries per pair
+
+    bool const was_damaged(Entity *a, Entity *b) const;
+    void damage(Entity *entity, Entity *other);
+
+public:
+    // The response to `type` running into `other_type`, or NULL if they pass through each other
+    static const PairResponse *get_response(int type, int other_type);
+
+    // The types `type` collides with, as collision layer bits (1 << type), straight from the response table
+    static unsigned int const get_default_mask(int type);
+
+    // Makes room for max_pairs contacts in one batch and max_pairs damaged pairs in one
+    // step, so a scene that never goes over them never allocates here
+    void reserve(int max_pairs);
+
+    void begin_step();
+
+    // Replaces the list with whatever `batch` (the ones still updating) overlaps in `collidables`.
+    // A nonzero sweep_time instead checks the whole path each entity covered in that time, just
+    // gone, and keeps only the first thing it ran into
+    void generate(Entity *const *batch, int count, Entity *collidables, int collidable_count, float sweep_time = 0.0f);
+
+    // Pushes everyone out of what they hit, then applies damage
+    void resolve();
+
+    const std::vector<Contact> &get_contacts() const { return contacts; };
+};
@@ -0,0 +1,86 @@
+#include "EnemyBehaviours.h"
+
+#define ALIEN_SIGHT_DISTANCE   6.0f  // how close the player gets before an alien goes for them
+#define ALIEN_CHASE_SECONDS    3.0f
+#define ALIEN_RETREAT_DISTANCE 10.0f // how far it backs off before lying in wait again
+
+// Straight at the player, one axis at a time
+static glm::vec3 towards(Entity *self, Entity *player)
+{
+    glm::vec3 position = self->get_position(), player_position = player->get_position();
+    return glm::vec3(position.x > player_position.x ? -1.0f : 1.0f,
+                     position.y > player_position.y ? -1.0f : 1.0f,
+                     0.0f);
+}
+
+// Drifts left for good
+static Behaviour walker(Entity *self, Entity * /* player */)
+{
+    self->set_movement(glm::vec3(-1.0f, 0.0f, 0.0f));
+    co_return;
+}
+
+// Waits until it can see the player nearby, then goes after them for good
+static Behaviour guard(Entity *self, Entity *player)
+{
+    if (self->get_ai_state() == IDLE) co_await player_in_sight(Entity::GUARD_WAKE_DISTANCE);
+    self->set_ai_state(WALKING);
+
+    while (true)
+    {
+        self->set_movement(towards(self, player));
+        co_await next_step();
+    }
+}
+
+// Lies in wait, chases the player for a while, backs off out of sight, and does it again
+static Behaviour alien(Entity *self, Entity *player)
+{
+    // Where a restored alien was up to; a fresh one is IDLE
+    AIState resume_from = self->get_ai_state();
+
+    while (true)
+    {
+        // Step 1: Wait
+        if (resume_from == IDLE)
+        {
+            self->set_movement(glm::vec3(0.0f));
+            co_await player_in_sight(ALIEN_SIGHT_DISTANCE);
+        }
+
+        // Step 2: Chase (a restored chase gets the full time again)
+        if (resume_from != WALKING)
+        {
+            self->set_ai_state(ATTACKING);
+            for (float chased = 0.0f; chased < ALIEN_CHASE_SECONDS; chased += co_await next_step())
+            {
+                self->set_movement(towards(self, player));
+            }
+        }
+
+        // Step 3: Retreat, straight away from where the player is now; a restored retreat keeps its heading
+        if (resume_from != WALKING) self->set_movement(-towards(self, player));
+        self->set_ai_state(WALKING);
+        co_await player_beyond(ALIEN_RETREAT_DISTANCE);
+
+        self->set_ai_state(IDLE);
+        resume_from = IDLE;
+    }
+}
+
+// Asteroids just keep going the way they were sent
+static Behaviour drifter(Entity * /* self */, Entity * /* player */)
+{
+    co_return;
+}
+
+Behaviour start_behaviour(AIType ai_type, Entity *self, Entity *player)
+{
+    switch (ai_type)
+    {
+        case WALKER: return walker(self, player);
+        case GUARD:  return guard(self, player);
+        case ALIEN:  return alien(self, player);
+        default:     return drifter(self, player);
+    }
+}
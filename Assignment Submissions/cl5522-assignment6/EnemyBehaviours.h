@@ -0,0 +1,14 @@
+#pragma once
+#include "Behaviour.h"
+#include "Entity.h"
+
+/**
+ * The script every AIType runs. An enemy starts its script the first time
+ * it thinks, and starts it over after set_ai_type() (restoring a snapshot
+ * included). Scripts start from the enemy's ai_state where that matters,
+ * so one restored mid-chase carries on chasing.
+ *
+ * A new kind of enemy is a new AIType plus a script here; what it waits on
+ * is checked without running the script, so waiting is close to free.
+ */
+Behaviour start_behaviour(AIType ai_type, Entity *self, Entity *player);
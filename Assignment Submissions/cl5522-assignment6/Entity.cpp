@@ -11,11 +11,17 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
 #include "Entity.h"
+#include "EntityRegistry.h"
+#include "PerfStats.h"
+
+#define COLLISION_BLOCK 64  // how many slots the overlap kernel looks at before we check for a hit
+
+EntityStore Entity::store;
 
 Entity::Entity()
 {
-    position     = glm::vec3(0.0f);
-    velocity     = glm::vec3(0.0f);
+    slot = store.add(this);
+    set_entity_type(entity_type);
     acceleration = glm::vec3(0.0f);
     
     movement = glm::vec3(0.0f);
@@ -30,380 +36,364 @@ Entity::~Entity()
     delete [] animation_down;
     delete [] animation_left;
     delete [] animation_right;
-    delete [] walking;
+    
+    if (registry != NULL) registry->remove(handle);
+    store.remove(slot);
 }
 
-void Entity::draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index)
+void Entity::activate()
 {
-    // Step 1: Calculate the UV location of the indexed frame
-    float u_coord = (float) (index % animation_cols) / (float) animation_cols;
-    float v_coord = (float) (index / animation_cols) / (float) animation_rows;
-    
-    // Step 2: Calculate its UV size
-    float width = 1.0f / (float) animation_cols;
-    float height = 1.0f / (float) animation_rows;
-    
-    // Step 3: Just as we have done before, match the texture coordinates to the vertices
-    float tex_coords[] =
-    {
-        u_coord, v_coord + height, u_coord + width, v_coord + height, u_coord + width, v_coord,
-        u_coord, v_coord + height, u_coord + width, v_coord, u_coord, v_coord
-    };
-    
-    float vertices[] =
-    {
-        -0.5, -0.5, 0.5, -0.5,  0.5, 0.5,
-        -0.5, -0.5, 0.5,  0.5, -0.5, 0.5
-    };
-    
-    // Step 4: And render
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->positionAttribute);
-    
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->texCoordAttribute);
-    
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
+    is_active = true;
+    store.active[slot] = 1.0f;
+    if (registry != NULL) registry->link(this);
 }
 
-void Entity::activate_ai(Entity *player)
+void Entity::deactivate()
 {
-    switch (ai_type)
-    {
-        case WALKER:
-            ai_walker();
-            break;
-            
-        case GUARD:
-            ai_guard(player);
-            break;
-            
-        default:
-            break;
-    }
+    is_active = false;
+    is_dormant = false;
+    store.active[slot] = 0.0f;
+    if (registry != NULL) registry->unlink(this);
 }
 
-void Entity::ai_walker()
+void Entity::fall_asleep()
 {
-    movement = glm::vec3(-1.0f, 0.0f, 0.0f);
+    if (is_dormant || !is_active) return;
+    
+    // Move to the dormant list
+    if (registry != NULL) registry->unlink(this);
+    is_dormant = true;
+    if (registry != NULL) registry->link(this);
 }
 
-void Entity::ai_guard(Entity *player)
+void Entity::wake_up()
 {
-    switch (ai_state) {
-        case IDLE:
-            if (glm::distance(position, player->position) < 6.0f) ai_state = WALKING;
-            break;
-            
-        case WALKING:
-            if (position.x > player->get_position().x) {
-                movement.x = -1.0f;
-            } else {
-                movement.x = 1.0f;
-            }
+    if (!is_dormant) return;
+    
+    if (registry != NULL) registry->unlink(this);
+    is_dormant = false;
+    if (registry != NULL) registry->link(this);
+}
 
-            if (position.y > player->get_position().y) {
-                movement.y = -1.0f;
-            }
-            else {
-                movement.y = 1.0f;
-            }
-            break;
-            
-        case ATTACKING:
-            break;
-            
-        default:
-            break;
-    }
+void const Entity::set_entity_type(EntityType new_entity_type)
+{
+    // Move to the right active list
+    if (registry != NULL) registry->unlink(this);
+    entity_type = new_entity_type;
+    if (registry != NULL && is_active) registry->link(this);
+    
+    // Collide with whatever the response table says this type responds to
+    store.collision_layer[slot] = 1u << entity_type;
+    store.collision_mask[slot]  = ContactList::get_default_mask(entity_type);
 }
 
-void Entity::update(float delta_time, Entity *player, Entity *objects, int object_count)
+void const Entity::set_ai_type(AIType new_ai_type)
 {
+    // Enemies are listed by AI too
+    if (registry != NULL) registry->unlink(this);
+    ai_type = new_ai_type;
+    if (registry != NULL && is_active) registry->link(this);
+    
+    // The new AI's script starts the next time we think
+    behaviour.reset();
+    ai_elapsed = 0.0f;
+}
 
-    //if (entity_type == PLAYER)std::cout << lives << std::endl;
+float Entity::calc_distance(Entity* other) {
+    float x_distance = fabs(store.position_x[slot] - store.position_x[other->slot]) - ((store.width[slot]  + store.width[other->slot])  / 2.0f);
+    float y_distance = fabs(store.position_y[slot] - store.position_y[other->slot]) - ((store.height[slot] + store.height[other->slot]) / 2.0f);
+    float distance = glm::sqrt((x_distance * x_distance) + (y_distance * y_distance));
+    return distance;
+}
 
-    if (lives <= 0) {
-        deactivate();
+// Whether the entities sit in consecutive store slots, in order
+bool Entity::has_contiguous_slots(Entity *entities, int entity_count)
+{
+    for (int i = 1; i < entity_count; i++)
+    {
+        if (entities[i].get_slot() != entities[0].get_slot() + i) return false;
     }
+    return true;
+}
 
-    if (!is_active) return;
-
-    acceleration = glm::vec3(0.0f);
-    move_rotate = glm::radians(0.0f);
- 
-    collided_top    = false;
-    collided_bottom = false;
-    collided_left   = false;
-    collided_right  = false;
+/**
+ * Index of the first entity at or after `from` that we overlap, or
+ * collidable_entity_count if there is none. Arrays that sit in consecutive
+ * store slots are handed to the SIMD overlap kernel a block at a time;
+ * anything else is checked one by one.
+ */
+int Entity::next_collision(Entity *collidable_entities, int collidable_entity_count, int from, bool is_contiguous) const
+{
+    if (!is_active || from >= collidable_entity_count) return collidable_entity_count;
     
-    if (entity_type == ENEMY) activate_ai(player);
+    int first_slot = collidable_entities[0].slot;
     
-    if (animation_indices != NULL)
+    if (!is_contiguous)
     {
-        if (glm::length(movement) != 0)
+        for (int i = from; i < collidable_entity_count; i++)
         {
-            animation_time += delta_time;
-            float frames_per_second = (float) 1 / SECONDS_PER_FRAME;
-            
-            if (animation_time >= frames_per_second)
-            {
-                animation_time = 0.0f;
-                animation_index++;
-                
-                if (animation_index >= animation_frames)
-                {
-                    animation_index = 0;
-                }
+            if (check_collision(&collidable_entities[i])) {
+                PerfStats::count_pairs(i - from + 1);
+                return i;
             }
         }
+        PerfStats::count_pairs(collidable_entity_count - from);
+        return collidable_entity_count;
     }
-
-    switch (entity_type) {
-    case PLAYER:
-        //Thrust
-        if (is_thrusting_up) {
-            //Step 1: Immediately return the flag to its originial false state
-            is_thrusting_up = false;
-            //Step 2: The player now acquires an upward velocity
-            //velocity.y += jumping_power;
-            acceleration.y = thrusting_power;
-            //LOG(acceleration.y);
-        }
-        else if (is_thrusting_down) {
-            is_thrusting_down = false;
-            acceleration.y = -thrusting_power;
-        }
-
-        if (is_thrusting_left) {
-            is_thrusting_left = false;
-            acceleration.x = -thrusting_power;
-        }
-        else if (is_thrusting_right) {
-            is_thrusting_right = false;
-            acceleration.x = thrusting_power;
-        }
-        else {
-            acceleration.x = 0;
-        }
-
-        if (is_rotating_counter) {
-            is_rotating_counter = false;
-            move_rotate += rotate_speed;
-            rotation += rotate_speed;
-            if (rotation >= glm::radians(360.0)) {
-                rotation -= glm::radians(360.0);
-            }
-        }
-        else if (is_rotating_clock) {
-            is_rotating_clock = false;
-            move_rotate -= rotate_speed;
-            rotation -= rotate_speed;
-            if (rotation <= glm::radians(-360.0)) {
-                rotation += glm::radians(360.0);
-            }
-        }
-        // Our character moves from left to right, so they need an initial velocity
-        //velocity.x = movement.x * speed;
-
-        // Now we add the rest of the gravity physics
-        velocity += acceleration * delta_time;
-
-        position.y += velocity.y * delta_time;
-        check_collision_y(objects, object_count);
-
-        position.x += velocity.x * delta_time;
-        check_collision_x(objects, object_count);
-
-        model_matrix = glm::mat4(1.0f);
-        model_matrix = glm::translate(model_matrix, position);
-        model_matrix = glm::rotate(model_matrix, rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-        break;
-
-    case ENEMY:
-        velocity.x = movement.x * speed;
-        velocity.y = movement.y * speed;
-
-        position.y += velocity.y * delta_time;
-        check_collision_y(objects, object_count);
-
-        position.x += velocity.x * delta_time;
-        check_collision_x(objects, object_count);
-
-        model_matrix = glm::mat4(1.0f);
-        model_matrix = glm::translate(model_matrix, position);
-        break;
-
-    case GREEN_LASER:
-
- 
-        velocity.y = glm::cos(rotation) * speed;
-        velocity.x = -glm::sin(rotation) * speed;
-
-        position.y += velocity.y * delta_time;
-        check_collision_y(objects, object_count);
-
-        position.x += velocity.x * delta_time;
-        check_collision_x(objects, object_count);
-
-        model_matrix = glm::mat4(1.0f);
-        model_matrix = glm::translate(model_matrix, position);
-
-        break;
-
-    case RED_LASER:
-        break;
-
+    
+    int hits[COLLISION_BLOCK];
+    for (int i = from; i < collidable_entity_count; i += COLLISION_BLOCK)
+    {
+        int block = collidable_entity_count - i < COLLISION_BLOCK ? collidable_entity_count - i : COLLISION_BLOCK;
+        PerfStats::count_pairs(block);
+        if (store.overlap(slot, first_slot + i, block, hits) > 0) return hits[0] - first_slot;
     }
-   
-}
-
-float Entity::calc_distance(Entity* other) {
-    float x_distance = fabs(position.x - other->position.x) - ((width + other->width) / 2.0f);
-    float y_distance = fabs(position.y - other->position.y) - ((height + other->height) / 2.0f);
-    float distance = glm::sqrt((x_distance * x_distance) + (y_distance * y_distance));
-    return distance;
+    return collidable_entity_count;
 }
 
-void const Entity::check_collision_y(Entity* collidable_entities, int collidable_entity_count)
+void const Entity::find_contacts(Entity *collidable_entities, int collidable_entity_count, bool is_contiguous, std::vector<Contact> *contacts)
 {
-    for (int i = 0; i < collidable_entity_count; i++)
+    float position_x = store.position_x[slot], position_y = store.position_y[slot];
+    float width = store.width[slot], height = store.height[slot];
+    
+    for (int i = next_collision(collidable_entities, collidable_entity_count, 0, is_contiguous);
+         i < collidable_entity_count;
+         i = next_collision(collidable_entities, collidable_entity_count, i + 1, is_contiguous))
     {
-        Entity* collidable_entity = &collidable_entities[i];
-
-        if (check_collision(collidable_entity))
-        {
-            float y_distance = fabs(position.y - collidable_entity->position.y);
-            float y_overlap = fabs(y_distance - (height / 2.0f) - (collidable_entity->height / 2.0f));
-            if (entity_type == PLAYER && collidable_entity->entity_type == ENEMY) {
-                //deactivate();
-                lives -= 1;
-            }
-            //else if (entity_type == ENEMY && collidable_entity->entity_type == PLAYER) {
-                //collidable_entity->lives -= 1;
-            //}
-            else if (entity_type == PLAYER && collidable_entity->entity_type == ENEMY) {
-                collidable_entity->lives -= 1;
-            }
-
-            else if (entity_type == GREEN_LASER && collidable_entity->entity_type == ENEMY) {
-                if (entity_type != BIG_ALIEN) {
-                    collidable_entity->lives -= 1;
-                }
-                deactivate();
-            }
-
-            if (position.y - (height / 5.0f) < collidable_entity->position.y - collidable_entity->get_height() / 2.0f) {
-                //if (entity_type == PLAYER && collidable_entity->entity_type == ENEMY) {
-                //    //deactivate();
-                //    lives -= 1;
-                //}
-                //else if (entity_type == ENEMY && collidable_entity->entity_type == PLAYER) {
-                //    collidable_entity->lives -= 1;
-                //}
-                position.y -= y_overlap + 0.5;
-                velocity.y = 0;
-                collided_top = true;
-            }
-            else if (position.y - (height / 5.0f) > collidable_entity->position.y + collidable_entity->get_height() / 2.0f) {
-                //Adding Special killing collision
-               /* if (entity_type == PLAYER && collidable_entity->entity_type == ENEMY) {
-                    collidable_entity->deactivate();
-                }*/
-                position.y += y_overlap+0.5;
-                velocity.y = 0;
-                collided_bottom = true;
-            }
-        }
+        Entity *collidable_entity = &collidable_entities[i];
+        int other_slot = collidable_entity->slot;
+        
+        Contact contact;
+        contact.entity    = this;
+        contact.other     = collidable_entity;
+        contact.overlap_x = (width  + store.width[other_slot])  / 2.0f - fabs(position_x - store.position_x[other_slot]);
+        contact.overlap_y = (height + store.height[other_slot]) / 2.0f - fabs(position_y - store.position_y[other_slot]);
+        contact.time      = 1.0f;
+        contact.impact    = glm::vec3(position_x, position_y, 0.0f);
+        
+        // Out along the shallower axis, away from the other's centre
+        if (contact.overlap_x < contact.overlap_y) contact.normal = glm::vec3(position_x < store.position_x[other_slot] ? -1.0f : 1.0f, 0.0f, 0.0f);
+        else                                       contact.normal = glm::vec3(0.0f, position_y < store.position_y[other_slot] ? -1.0f : 1.0f, 0.0f);
+        
+        contacts->push_back(contact);
     }
 }
 
-void const Entity::check_collision_x(Entity* collidable_entities, int collidable_entity_count)
+/**
+ * The first entity we hit anywhere along the move we just made, going by
+ * our velocity over delta_time, rather than only where we ended up.
+ *
+ * Each collidable's box is grown by half our size on every side, so that
+ * our box touching it is the same as our centre being inside the grown
+ * box. Our centre moves in a straight line, and the slab test gives the
+ * fraction of the move at which that line enters and leaves the grown box
+ * along each axis; we are inside once we have entered along both.
+ */
+void const Entity::find_swept_contact(Entity *collidable_entities, int collidable_entity_count, float delta_time, std::vector<Contact> *contacts)
 {
+    if (!is_active) return;
+    
+    float end_x = store.position_x[slot], end_y = store.position_y[slot];
+    float move_x = store.velocity_x[slot] * delta_time, move_y = store.velocity_y[slot] * delta_time;
+    float start_x = end_x - move_x, start_y = end_y - move_y;
+    unsigned int mask = store.collision_mask[slot];
+    if (mask == 0) return;
+    
+    PerfStats::count_pairs(collidable_entity_count);
+    
+    Contact contact;
+    contact.entity = NULL;
+    contact.time   = 1.0f;
+    
     for (int i = 0; i < collidable_entity_count; i++)
     {
-        Entity* collidable_entity = &collidable_entities[i];
-
-        if (check_collision(collidable_entity))
-        {
-            float x_distance = fabs(position.x - collidable_entity->position.x);
-            float x_overlap = fabs(x_distance - (width / 2.0f) - (collidable_entity->width / 2.0f));
-
-            if (entity_type == PLAYER && collidable_entity->entity_type == ENEMY) {
-                //deactivate();
-                lives -= 1;
-            }
-            else if (entity_type == ENEMY && collidable_entity->entity_type == PLAYER) {
-                collidable_entity->lives -= 1;
-            }
-           
-
-            else if (entity_type == GREEN_LASER && collidable_entity->entity_type == ENEMY) {
-                if (entity_type != BIG_ALIEN) {
-                    collidable_entity->lives -= 1;
-                }
-                deactivate();
-            }
-
-            if (position.x < collidable_entity->position.x) {
-                //if (entity_type == PLAYER && collidable_entity->entity_type == ENEMY) {
-                //    //deactivate();
-                //    lives -= 1;
-                //}
-                /*else if (entity_type == ENEMY && collidable_entity->entity_type == PLAYER) {
-                    collidable_entity->lives -= 1;
-                }*/
-                position.x -= x_overlap+0.5;
-                velocity.x = 0;
-                collided_right = true;
-            }
-            else if (position.x > collidable_entity->position.x) {
-                //if (entity_type == PLAYER && collidable_entity->entity_type == ENEMY) {
-                //    //deactivate();
-                //    lives -= 1;
-                //}
-                //else if (entity_type == ENEMY && collidable_entity->entity_type == PLAYER) {
-                //    collidable_entity->lives -= 1;
-                //}
-                position.x += x_overlap+0.5;
-                velocity.x = 0;
-                collided_left = true;
-            }
+        Entity *other = &collidable_entities[i];
+        int other_slot = other->slot;
+        if (other == this || !other->is_active || (store.collision_layer[other_slot] & mask) == 0) continue;
+        
+        float half_width  = (store.width[slot]  + store.width[other_slot])  / 2.0f;
+        float half_height = (store.height[slot] + store.height[other_slot]) / 2.0f;
+        float other_x = store.position_x[other_slot], other_y = store.position_y[other_slot];
+        
+        // Step 1: When we are within reach along each axis. Not moving along one means always or never
+        float enter_x = -INFINITY, leave_x = INFINITY;
+        if (move_x != 0.0f) {
+            float t1 = (other_x - half_width - start_x) / move_x, t2 = (other_x + half_width - start_x) / move_x;
+            enter_x = fmin(t1, t2);
+            leave_x = fmax(t1, t2);
         }
+        else if (fabs(start_x - other_x) >= half_width) continue;
+        
+        float enter_y = -INFINITY, leave_y = INFINITY;
+        if (move_y != 0.0f) {
+            float t1 = (other_y - half_height - start_y) / move_y, t2 = (other_y + half_height - start_y) / move_y;
+            enter_y = fmin(t1, t2);
+            leave_y = fmax(t1, t2);
+        }
+        else if (fabs(start_y - other_y) >= half_height) continue;
+        
+        // Step 2: Both at once, sometime during this move, and sooner than anything else we hit
+        float enter = fmax(enter_x, enter_y), leave = fmin(leave_x, leave_y);
+        if (enter >= leave || leave <= 0.0f || enter >= 1.0f) continue;
+        
+        float time = fmax(enter, 0.0f);
+        if (contact.entity != NULL && time >= contact.time) continue;
+        
+        float impact_x = start_x + move_x * time, impact_y = start_y + move_y * time;
+        
+        contact.entity    = this;
+        contact.other     = other;
+        contact.time      = time;
+        contact.impact    = glm::vec3(impact_x, impact_y, 0.0f);
+        contact.overlap_x = half_width  - fabs(impact_x - other_x);
+        contact.overlap_y = half_height - fabs(impact_y - other_y);
+        
+        // Out the way we came in: along the axis we reached last. Already inside when
+        // the move started, so out along the shallower axis as with a plain overlap
+        bool is_x_axis = enter > 0.0f ? enter_x > enter_y : contact.overlap_x < contact.overlap_y;
+        if (is_x_axis) contact.normal = glm::vec3(impact_x < other_x ? -1.0f : 1.0f, 0.0f, 0.0f);
+        else           contact.normal = glm::vec3(0.0f, impact_y < other_y ? -1.0f : 1.0f, 0.0f);
     }
+    
+    if (contact.entity != NULL) contacts->push_back(contact);
 }
 
-void Entity::render(ShaderProgram *program)
+void const Entity::resolve_contact(const Contact &contact)
 {
-    if (!is_active) return;
+    float &position_x = store.position_x[slot], &position_y = store.position_y[slot];
+    float &velocity_x = store.velocity_x[slot], &velocity_y = store.velocity_y[slot];
+    int other_slot = contact.other->slot;
+    
+    // Hit partway through the move: back up to where we first touched
+    bool is_swept = contact.time < 1.0f;
+    if (is_swept) {
+        position_x = contact.impact.x;
+        position_y = contact.impact.y;
+    }
     
-    program->SetModelMatrix(model_matrix);
+    // Pushed clear by an earlier contact already? Just touching is still a hit for a swept one
+    float overlap_x = (store.width[slot]  + store.width[other_slot])  / 2.0f - fabs(position_x - store.position_x[other_slot]);
+    float overlap_y = (store.height[slot] + store.height[other_slot]) / 2.0f - fabs(position_y - store.position_y[other_slot]);
+    if (is_swept) {
+        overlap_x = fmax(overlap_x, 0.0f);
+        overlap_y = fmax(overlap_y, 0.0f);
+    }
+    else if (overlap_x <= 0.0f || overlap_y <= 0.0f) return;
     
-    if (animation_indices != NULL)
-    {
-        draw_sprite_from_texture_atlas(program, texture_id, animation_indices[animation_index]);
-        return;
+    // Bounce back a little further than just touching
+    if (contact.normal.x < 0.0f) {
+        position_x -= overlap_x + 0.5;
+        velocity_x = 0;
+        collided_right = true;
     }
+    else if (contact.normal.x > 0.0f) {
+        position_x += overlap_x + 0.5;
+        velocity_x = 0;
+        collided_left = true;
+    }
+    else if (contact.normal.y < 0.0f) {
+        position_y -= overlap_y + 0.5;
+        velocity_y = 0;
+        collided_top = true;
+    }
+    else {
+        position_y += overlap_y + 0.5;
+        velocity_y = 0;
+        collided_bottom = true;
+    }
+}
+
+glm::vec3 const Entity::get_interpolated_position(float alpha) const
+{
+    float x = store.previous_x[slot] + (store.position_x[slot] - store.previous_x[slot]) * alpha;
+    float y = store.previous_y[slot] + (store.position_y[slot] - store.previous_y[slot]) * alpha;
+    return glm::vec3(x, y, 0.0f);
+}
+
+void Entity::render(ShaderProgram *program, RenderQueue *queue, float alpha)
+{
+    if (!is_active) return;
     
-    float vertices[]   = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-    float tex_coords[] = {  0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
+    // Step 1: Draw ourselves partway between the last two steps. The model matrix
+    //         is translate * (rotate, scale...) as of the current step, so swap its
+    //         translation for the in-between one and undo part of this step's turn
+    float turned = rotation - previous_rotation;
+    if (turned >  glm::radians(180.0f)) turned -= glm::radians(360.0f);
+    if (turned < -glm::radians(180.0f)) turned += glm::radians(360.0f);
     
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glm::mat4 interpolated_matrix = model_matrix;
+    interpolated_matrix[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    if (turned != 0.0f) interpolated_matrix = glm::rotate(glm::mat4(1.0f), (alpha - 1.0f) * turned, glm::vec3(0.0f, 0.0f, 1.0f)) * interpolated_matrix;
+    interpolated_matrix = glm::translate(glm::mat4(1.0f), get_interpolated_position(alpha)) * interpolated_matrix;
     
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->positionAttribute);
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->texCoordAttribute);
+    // Step 2: Queue it
+    RenderCommand *command = queue->add(program, entity_type == PLAYER ? RENDER_LAYER_PLAYER : RENDER_LAYER_WORLD, texture_id);
+    command->model_matrix = interpolated_matrix;
     
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    // Animated entities show one frame of their sheet, picked out in the shader;
+    // everything else is a 1x1 "sheet" with a single frame
+    if (animation_indices != NULL)
+    {
+        command->sprite_cols  = animation_cols;
+        command->sprite_rows  = animation_rows;
+        command->sprite_index = animation_indices[animation_index];
+    }
+}
+
+void Entity::save(EntitySnapshot *snapshot) const
+{
+    snapshot->is_active       = is_active;
+    snapshot->lives           = lives;
+    snapshot->entity_type     = entity_type;
+    snapshot->ai_type         = ai_type;
+    snapshot->ai_state        = ai_state;
+    snapshot->position        = get_position();
+    snapshot->velocity        = get_velocity();
+    snapshot->acceleration    = acceleration;
+    snapshot->movement        = movement;
+    snapshot->width           = store.width[slot];
+    snapshot->height          = store.height[slot];
+    snapshot->speed           = speed;
+    snapshot->rotation        = rotation;
+    snapshot->rotate_speed    = rotate_speed;
+    snapshot->thrusting_power = thrusting_power;
+    snapshot->animation_index = animation_index;
+    snapshot->animation_time  = animation_time;
+    snapshot->texture_id      = texture_id;
+    snapshot->model_matrix    = model_matrix;
+    snapshot->collision_layer = store.collision_layer[slot];
+    snapshot->collision_mask  = store.collision_mask[slot];
+}
+
+void Entity::restore(const EntitySnapshot &snapshot)
+{
+    // These decide which active lists we are on. Start out awake: if there's
+    // nothing to do we'll go back to sleep after our next update
+    is_dormant = false;
+    set_entity_type(snapshot.entity_type);
+    set_ai_type(snapshot.ai_type);
+    if (snapshot.is_active) activate();
+    else                    deactivate();
     
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
+    lives           = snapshot.lives;
+    ai_state        = snapshot.ai_state;
+    set_position(snapshot.position);
+    set_velocity(snapshot.velocity);
+    acceleration    = snapshot.acceleration;
+    movement        = snapshot.movement;
+    set_width(snapshot.width);
+    set_height(snapshot.height);
+    speed           = snapshot.speed;
+    rotation        = snapshot.rotation;
+    previous_rotation = rotation;
+    rotate_speed    = snapshot.rotate_speed;
+    thrusting_power = snapshot.thrusting_power;
+    animation_index = snapshot.animation_index;
+    animation_time  = snapshot.animation_time;
+    texture_id      = snapshot.texture_id;
+    model_matrix    = snapshot.model_matrix;
+    set_collision_layer(snapshot.collision_layer);
+    set_collision_mask(snapshot.collision_mask);
 }
 
 bool const Entity::check_collision(Entity *other) const
@@ -414,8 +404,11 @@ bool const Entity::check_collision(Entity *other) const
     // If either entity is inactive, there shouldn't be any collision
     if (!is_active || !other->is_active) return false;
     
-    float x_distance = fabs(position.x - other->position.x) - ((width  + other->width)  / 2.0f);
-    float y_distance = fabs(position.y - other->position.y) - ((height + other->height) / 2.0f);
+    // Nor if we don't collide with its kind
+    if ((store.collision_layer[other->slot] & store.collision_mask[slot]) == 0) return false;
+    
+    float x_distance = fabs(store.position_x[slot] - store.position_x[other->slot]) - ((store.width[slot]  + store.width[other->slot])  / 2.0f);
+    float y_distance = fabs(store.position_y[slot] - store.position_y[other->slot]) - ((store.height[slot] + store.height[other->slot]) / 2.0f);
     
     return x_distance < 0.0f && y_distance < 0.0f;
 }
@@ -1,34 +1,104 @@
 #pragma once
 #include "Map.h"
+#include "EntityStore.h"
+#include "RenderQueue.h"
+#include "ContactList.h"
+#include "Behaviour.h"
 
 enum EntityType { PLATFORM, PLAYER, ENEMY, GREEN_LASER, RED_LASER};
 enum AIType     { WALKER, GUARD, ASTEROID, ALIEN, BIG_ALIEN            };
 enum AIState    { WALKING, IDLE, ATTACKING, PATROLLING };
 
+class EntityRegistry;
+
+// Refers to an entity in an EntityRegistry; goes stale once the entity is removed
+struct EntityHandle
+{
+    int index = -1;
+    unsigned int generation = 0;
+};
+
+/**
+ * Everything an entity needs to pick up exactly where it left off, with no
+ * pointers in it, so it can be memcpy'd into and out of a flat buffer.
+ * Animation frame tables are set up by initialise() and are not included.
+ */
+struct EntitySnapshot
+{
+    bool is_active;
+    int lives;
+    EntityType entity_type;
+    AIType ai_type;
+    AIState ai_state;
+    
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec3 acceleration;
+    glm::vec3 movement;
+    float width;
+    float height;
+    float speed;
+    
+    float rotation;
+    float rotate_speed;
+    float thrusting_power;
+    int animation_index;
+    float animation_time;
+    
+    GLuint texture_id;
+    glm::mat4 model_matrix;
+    unsigned int collision_layer;
+    unsigned int collision_mask;
+};
+
 class Entity
 {
 private:
     bool is_active = true;
     int lives = 5;
-    EntityType entity_type;
-    AIType ai_type;
-    AIState ai_state;
+    EntityType entity_type = PLATFORM;
+    AIType ai_type         = WALKER;
+    AIState ai_state       = IDLE;
     
     int *animation_right = NULL; // move to the right
     int *animation_left  = NULL; // move to the left
     int *animation_up    = NULL; // move upwards
     int *animation_down  = NULL; // move downwards
     
-    glm::vec3 position;
-    glm::vec3 velocity;
+    // Position, velocity, size and the active flag live in `store` under this slot
+    int slot;
     glm::vec3 acceleration;
     
-    float width  = 0.8f;
-    float height = 0.8f;
+    // The scene registry that lists us, if any
+    EntityRegistry *registry = NULL;
+    EntityHandle handle;
+    
+    int next_collision(Entity *collidable_entities, int collidable_entity_count, int from, bool is_contiguous) const;
+    
+    // Left out of updates until something wakes us; see fall_asleep()
+    bool is_dormant = false;
+    
+    // Set by AIScheduler when it isn't our turn to think; lasts one update
+    bool is_skipping_ai = false;
+    
+    // Our AI's script (see EnemyBehaviours.h), and the time since it last ran
+    Behaviour behaviour;
+    float ai_elapsed = 0.0f;
+    
+    // An update in parts, so update_system() can run each part over a whole batch
+    bool is_updating = false; // still taking part in the current update
+    template <EntityType TYPE, AIType AI> bool begin_update(float delta_time, Entity *player);
+    template <EntityType TYPE> void end_update();
+    template <AIType AI> void run_ai(Entity *player, float delta_time);
+    
+    template <EntityType TYPE, AIType AI>
+    friend void update_system(Entity *const *batch, int count, float delta_time, Entity *player, Entity *objects, int object_count, ContactList *contacts);
     
 public:
     // Static attributes
     static const int SECONDS_PER_FRAME = 4;
+    static constexpr float GUARD_WAKE_DISTANCE = 6.0f; // how close the player gets (in sight) before an idle guard comes after it
+    static EntityStore store;
     static const int LEFT  = 0,
                      RIGHT = 1,
                      UP    = 2,
@@ -43,7 +113,7 @@ public:
     glm::vec3 movement;
     
     // Animating
-    int **walking          = new int*[4] { animation_left, animation_right, animation_up, animation_down };
+    int *walking[4]        = { animation_left, animation_right, animation_up, animation_down };
     int *animation_indices = NULL;
     int animation_frames   = 0;
     int animation_index    = 0;
@@ -65,6 +135,7 @@ public:
     bool is_rotating_clock = false;
     bool is_rotating_counter = false;
     float rotate_speed = glm::radians(2.0);
+    float previous_rotation = glm::radians(0.0); // before the current step, for drawing in between steps
     
     // Colliding
     bool collided_top    = false;
@@ -75,46 +146,72 @@ public:
     // Methods
     Entity();
     ~Entity();
+    
+    // Each entity owns a store slot, so copies would share (and later free) it
+    Entity(const Entity &) = delete;
+    Entity &operator=(const Entity &) = delete;
 
-    void draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index);
+    // One fixed step for this entity on its own; see UpdateSystem.h for doing many at once
     void update(float delta_time, Entity *player, Entity *objects, int object_count);
-    void render(ShaderProgram *program);
-    void activate_ai(Entity *player);
-    void ai_walker();
-    void ai_guard(Entity *player);
+    // alpha: how far we are from the previous step to the current one, 0 to 1
+    void render(ShaderProgram *program, RenderQueue *queue, float alpha);
+    void save(EntitySnapshot *snapshot) const;
+    void restore(const EntitySnapshot &snapshot);
     
     float calc_distance(Entity* other);
-    void const check_collision_y(Entity *collidable_entities, int collidable_entity_count);
-    void const check_collision_x(Entity *collidable_entities, int collidable_entity_count);
+    // Adds a contact for everything in collidable_entities we overlap right now
+    void const find_contacts(Entity *collidable_entities, int collidable_entity_count, bool is_contiguous, std::vector<Contact> *contacts);
+    void const find_swept_contact(Entity *collidable_entities, int collidable_entity_count, float delta_time, std::vector<Contact> *contacts);
+    void const resolve_contact(const Contact &contact);
+    static bool has_contiguous_slots(Entity *entities, int entity_count);
     void const check_collision_y(Map *map);
     void const check_collision_x(Map *map);
     
     bool const check_collision(Entity *other) const;
     
-    void activate()   { is_active = true;  };
-    void deactivate() { is_active = false; };
+    void activate();
+    void deactivate();
+    
+    // A dormant entity is still active, drawn and collided with, but isn't
+    // updated, so it must not be doing anything an update would change
+    void fall_asleep();
+    void wake_up();
     
     EntityType const get_entity_type()  const { return entity_type;  };
     AIType     const get_ai_type()      const { return ai_type;      };
     AIState    const get_ai_state()     const { return ai_state;     };
-    glm::vec3  const get_position()     const { return position;     };
+    glm::vec3  const get_position()     const { return glm::vec3(store.position_x[slot], store.position_y[slot], 0.0f); };
+    glm::vec3  const get_interpolated_position(float alpha) const;
     glm::vec3  const get_movement()     const { return movement;     };
-    glm::vec3  const get_velocity()     const { return velocity;     };
+    glm::vec3  const get_velocity()     const { return glm::vec3(store.velocity_x[slot], store.velocity_y[slot], 0.0f); };
     glm::vec3  const get_acceleration() const { return acceleration; };
-    int        const get_width()        const { return width;        };
-    int        const get_height()       const { return height;       };
+    int        const get_width()        const { return store.width[slot];  };
+    int        const get_height()       const { return store.height[slot]; };
+    int        const get_slot()         const { return slot; };
+    EntityHandle const get_handle()     const { return handle; };
     bool       const get_active_state() const { return is_active; };
+    bool       const get_updating_state() const { return is_updating; };
+    bool       const get_dormant_state()  const { return is_dormant; };
     int        const get_lives()        const { return lives; };
+    unsigned int const get_collision_layer() const { return store.collision_layer[slot]; };
+    unsigned int const get_collision_mask()  const { return store.collision_mask[slot];  };
     float const get_roatation() const { return rotation; };
     
-    void const set_entity_type(EntityType new_entity_type)  { entity_type  = new_entity_type;      };
-    void const set_ai_type(AIType new_ai_type)              { ai_type      = new_ai_type;          };
+    void const set_entity_type(EntityType new_entity_type);
+    void const set_ai_type(AIType new_ai_type);
     void const set_ai_state(AIState new_state)              { ai_state     = new_state;            };
-    void const set_position(glm::vec3 new_position)         { position     = new_position;         };
+    // A teleport, so previous_x/y move too and it isn't drawn sliding there
+    void const set_position(glm::vec3 new_position)         { store.position_x[slot] = store.previous_x[slot] = new_position.x;
+                                                              store.position_y[slot] = store.previous_y[slot] = new_position.y; };
     void const set_movement(glm::vec3 new_movement)         { movement     = new_movement;         };
-    void const set_velocity(glm::vec3 new_velocity)         { velocity     = new_velocity;         };
+    void const set_velocity(glm::vec3 new_velocity)         { store.velocity_x[slot] = new_velocity.x; store.velocity_y[slot] = new_velocity.y; };
     void const set_acceleration(glm::vec3 new_acceleration) { acceleration = new_acceleration;     };
-    void const set_width(float new_width)                   { width        = new_width;            };
-    void const set_height(float new_height)                 { height       = new_height;           };
+    void const set_width(float new_width)                   { store.width[slot]  = new_width;      };
+    void const set_height(float new_height)                 { store.height[slot] = new_height;     };
     void const set_lives(int new_lives)                     { lives = new_lives; };
+    void const set_skipping_ai(bool new_skipping_ai)        { is_skipping_ai = new_skipping_ai; };
+    // Both reset by set_entity_type(); the mask is which layers we look for when we move
+    void const set_collision_layer(unsigned int new_layer)  { store.collision_layer[slot] = new_layer; };
+    void const set_collision_mask(unsigned int new_mask)    { store.collision_mask[slot]  = new_mask;  };
+    void const set_registry(EntityRegistry *new_registry, EntityHandle new_handle) { registry = new_registry; handle = new_handle; };
 };
@@ -0,0 +1,103 @@
+#include "EntityRegistry.h"
+
+void EntityRegistry::reserve(int entity_count)
+{
+    entities.reserve(entity_count);
+    generations.reserve(entity_count);
+    free_indices.reserve(entity_count);
+    type_positions.reserve(entity_count);
+    archetype_positions.reserve(entity_count);
+    list_archetypes.reserve(entity_count);
+
+    for (std::vector<Entity*> &list : active_lists)    list.reserve(entity_count);
+    for (std::vector<Entity*> &list : archetype_lists) list.reserve(entity_count);
+}
+
+EntityHandle EntityRegistry::add(Entity *entity)
+{
+    // Step 1: Take a freed index if there is one
+    EntityHandle handle;
+    if (!free_indices.empty())
+    {
+        handle.index = free_indices.back();
+        free_indices.pop_back();
+        entities[handle.index] = entity;
+    }
+    else
+    {
+        handle.index = (int) entities.size();
+        entities.push_back(entity);
+        generations.push_back(0);
+        type_positions.push_back(-1);
+        archetype_positions.push_back(-1);
+        list_archetypes.push_back(-1);
+    }
+    handle.generation = generations[handle.index];
+
+    // Step 2: Tell the entity, and list it if it is already switched on
+    entity->set_registry(this, handle);
+    if (entity->get_active_state()) link(entity);
+
+    return handle;
+}
+
+void EntityRegistry::remove(EntityHandle handle)
+{
+    Entity *entity = get(handle);
+    if (entity == NULL) return;
+
+    unlink(entity);
+    entity->set_registry(NULL, EntityHandle());
+
+    entities[handle.index] = NULL;
+    generations[handle.index]++;
+    free_indices.push_back(handle.index);
+}
+
+Entity *EntityRegistry::get(EntityHandle handle) const
+{
+    if (handle.index < 0 || handle.index >= (int) entities.size()) return NULL;
+    if (generations[handle.index] != handle.generation) return NULL;
+    return entities[handle.index];
+}
+
+void EntityRegistry::link(Entity *entity)
+{
+    int index = entity->get_handle().index;
+    if (list_archetypes[index] >= 0) return;
+
+    int archetype = get_archetype(entity->get_entity_type(), entity->get_ai_type());
+    if (entity->get_dormant_state()) archetype += ARCHETYPE_COUNT;
+
+    std::vector<Entity*> &type_list      = active_lists[entity->get_entity_type()];
+    std::vector<Entity*> &archetype_list = archetype_lists[archetype];
+
+    type_positions[index]      = (int) type_list.size();
+    archetype_positions[index] = (int) archetype_list.size();
+    list_archetypes[index]     = archetype;
+    type_list.push_back(entity);
+    archetype_list.push_back(entity);
+}
+
+// Swap-remove: the last entity fills the gap
+void EntityRegistry::remove_from(std::vector<Entity*> &list, std::vector<int> &positions, int position)
+{
+    Entity *last = list.back();
+    list[position] = last;
+    positions[last->get_handle().index] = position;
+    list.pop_back();
+}
+
+void EntityRegistry::unlink(Entity *entity)
+{
+    int index = entity->get_handle().index;
+    int archetype = list_archetypes[index];
+    if (archetype < 0) return;
+
+    remove_from(active_lists[archetype % ARCHETYPE_COUNT / AI_TYPE_COUNT], type_positions, type_positions[index]);
+    remove_from(archetype_lists[archetype], archetype_positions, archetype_positions[index]);
+
+    type_positions[index]      = -1;
+    archetype_positions[index] = -1;
+    list_archetypes[index]     = -1;
+}
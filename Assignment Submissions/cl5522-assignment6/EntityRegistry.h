@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include "Entity.h"
+
+/**
+ * Keeps track of a scene's entities so loops only visit the live ones.
+ *
+ * Every entity added gets a handle: its index in the registry plus the
+ * generation of that index. Removing an entity bumps the generation, so
+ * an old handle to a reused index looks the entity up as NULL instead of
+ * pointing at whatever took its place.
+ *
+ * Active entities are also kept in one dense list per EntityType, and in
+ * one per archetype: the type plus, for enemies, the AIType (everything
+ * else files under WALKER). Entities join and leave these lists as they are
+ * activated and deactivated (swap with the last one, then pop), so counting
+ * them is O(1). Removing from a list reorders it, so loops that can
+ * deactivate what they are looking at should walk it back to front.
+ *
+ * Dormant entities (see Entity::fall_asleep) stay on their type's list, so
+ * they are still drawn, counted and collided with, but move from their
+ * archetype's list to its dormant list, so the update systems never see them.
+ */
+class EntityRegistry {
+public:
+    static const int TYPE_COUNT    = RED_LASER + 1;
+    static const int AI_TYPE_COUNT = BIG_ALIEN + 1;
+
+    static const int ARCHETYPE_COUNT = TYPE_COUNT * AI_TYPE_COUNT;
+
+    static int const get_archetype(EntityType type, AIType ai_type) { return type * AI_TYPE_COUNT + (type == ENEMY ? ai_type : 0); };
+
+private:
+
+    std::vector<Entity*> entities;
+    std::vector<unsigned int> generations;
+    std::vector<int> free_indices;
+
+    // Where each index sits in its active lists, and which archetype it was listed under
+    std::vector<int> type_positions;
+    std::vector<int> archetype_positions;
+    std::vector<int> list_archetypes;
+    std::vector<Entity*> active_lists[TYPE_COUNT];
+    std::vector<Entity*> archetype_lists[ARCHETYPE_COUNT * 2]; // awake, then dormant
+
+    void remove_from(std::vector<Entity*> &list, std::vector<int> &positions, int position);
+
+public:
+    // Makes room for entity_count entities in every list, so adding and linking that
+    // many never allocates
+    void reserve(int entity_count);
+
+    EntityHandle add(Entity *entity);
+    void remove(EntityHandle handle);
+    Entity *get(EntityHandle handle) const;
+
+    // Called by Entity whenever it is switched on/off, falls asleep/wakes up or changes type or AI
+    void link(Entity *entity);
+    void unlink(Entity *entity);
+
+    const std::vector<Entity*> &get_active(EntityType type) const { return active_lists[type]; };
+    const std::vector<Entity*> &get_active(EntityType type, AIType ai_type) const { return archetype_lists[get_archetype(type, ai_type)]; };
+    const std::vector<Entity*> &get_dormant(EntityType type, AIType ai_type) const { return archetype_lists[get_archetype(type, ai_type) + ARCHETYPE_COUNT]; };
+    int const get_active_count(EntityType type) const { return (int) active_lists[type].size(); };
+};
@@ -0,0 +1,324 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "EntityStore.h"
+#include "AllocationTracker.h"
+
+#define INITIAL_CAPACITY 64
+#define STORE_ALIGNMENT 32
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define STORE_USE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit SSE/AVX instructions in functions that ask for them
+#if defined(STORE_USE_X86) && defined(__GNUC__)
+#define SSE_FUNCTION __attribute__((target("sse2")))
+#define AVX_FUNCTION __attribute__((target("avx")))
+#else
+#define SSE_FUNCTION
+#define AVX_FUNCTION
+#endif
+
+/**
+ ALLOCATION
+ */
+template <typename T>
+static T *allocate_array(int count)
+{
+    return (T*) AllocationTracker::allocate_aligned(sizeof(T) * count, STORE_ALIGNMENT);
+}
+
+template <typename T>
+static void free_array(T *array)
+{
+    AllocationTracker::release_aligned(array);
+}
+
+template <typename T>
+static T *regrow(T *old_array, int count, int new_capacity)
+{
+    T *array = allocate_array<T>(new_capacity);
+    memset(array, 0, sizeof(T) * new_capacity);
+    if (old_array != NULL)
+    {
+        memcpy(array, old_array, sizeof(T) * count);
+        free_array(old_array);
+    }
+    return array;
+}
+
+/**
+ ISA DETECTION
+ */
+static EntityStore::Isa detect_isa()
+{
+#if defined(STORE_USE_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+
+    bool has_sse2 = (info[3] & (1 << 26)) != 0;
+    bool has_avx  = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0;
+
+    // The OS also has to save the YMM registers for us
+    if (has_avx && (_xgetbv(0) & 6) == 6) return EntityStore::ISA_AVX;
+    if (has_sse2) return EntityStore::ISA_SSE;
+#elif defined(STORE_USE_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx"))  return EntityStore::ISA_AVX;
+    if (__builtin_cpu_supports("sse2")) return EntityStore::ISA_SSE;
+#endif
+    return EntityStore::ISA_SCALAR;
+}
+
+/**
+ KERNELS
+ */
+static void integrate_scalar(float *position, const float *velocity, int first, int end, float delta_time)
+{
+    for (int i = first; i < end; i++) position[i] += velocity[i] * delta_time;
+}
+
+static int overlap_scalar(const EntityStore *store, int slot, int first, int end, int *hits, int hit_count)
+{
+    float x = store->position_x[slot], y = store->position_y[slot];
+    float w = store->width[slot],      h = store->height[slot];
+    unsigned int mask = store->collision_mask[slot];
+
+    for (int j = first; j < end; j++)
+    {
+        if ((store->collision_layer[j] & mask) == 0) continue;
+
+        float x_distance = fabs(x - store->position_x[j]) - ((w + store->width[j])  / 2.0f);
+        float y_distance = fabs(y - store->position_y[j]) - ((h + store->height[j]) / 2.0f);
+
+        if (x_distance < 0.0f && y_distance < 0.0f && store->active[j] > 0.0f && j != slot) hits[hit_count++] = j;
+    }
+    return hit_count;
+}
+
+#ifdef STORE_USE_X86
+SSE_FUNCTION static int integrate_sse(float *position, const float *velocity, int first, int end, float delta_time)
+{
+    __m128 dt = _mm_set1_ps(delta_time);
+
+    int i = first;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 p = _mm_loadu_ps(position + i);
+        _mm_storeu_ps(position + i, _mm_add_ps(p, _mm_mul_ps(_mm_loadu_ps(velocity + i), dt)));
+    }
+    return i;
+}
+
+SSE_FUNCTION static int overlap_sse(const EntityStore *store, int slot, int first, int end, int *hits, int *hit_count)
+{
+    __m128 x = _mm_set1_ps(store->position_x[slot]), y = _mm_set1_ps(store->position_y[slot]);
+    __m128 w = _mm_set1_ps(store->width[slot]),      h = _mm_set1_ps(store->height[slot]);
+    __m128 half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps();
+    __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128i collision_mask = _mm_set1_epi32((int) store->collision_mask[slot]), zero_bits = _mm_setzero_si128();
+
+    int j = first;
+    for (; j + 4 <= end; j += 4)
+    {
+        __m128 x_distance = _mm_sub_ps(_mm_and_ps(_mm_sub_ps(x, _mm_loadu_ps(store->position_x + j)), abs_mask),
+                                       _mm_mul_ps(_mm_add_ps(w, _mm_loadu_ps(store->width + j)), half));
+        __m128 y_distance = _mm_sub_ps(_mm_and_ps(_mm_sub_ps(y, _mm_loadu_ps(store->position_y + j)), abs_mask),
+                                       _mm_mul_ps(_mm_add_ps(h, _mm_loadu_ps(store->height + j)), half));
+
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(x_distance, zero), _mm_cmplt_ps(y_distance, zero)),
+                                _mm_cmpgt_ps(_mm_loadu_ps(store->active + j), zero));
+
+        // Drop the lanes whose layer we don't collide with
+        __m128i layers = _mm_and_si128(_mm_loadu_si128((const __m128i*) (store->collision_layer + j)), collision_mask);
+        hit = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(layers, zero_bits)), hit);
+
+        int mask = _mm_movemask_ps(hit);
+        for (int lane = 0; mask != 0 && lane < 4; lane++)
+        {
+            if ((mask & (1 << lane)) && j + lane != slot) hits[(*hit_count)++] = j + lane;
+        }
+    }
+    return j;
+}
+
+AVX_FUNCTION static int integrate_avx(float *position, const float *velocity, int first, int end, float delta_time)
+{
+    __m256 dt = _mm256_set1_ps(delta_time);
+
+    int i = first;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 p = _mm256_loadu_ps(position + i);
+        _mm256_storeu_ps(position + i, _mm256_add_ps(p, _mm256_mul_ps(_mm256_loadu_ps(velocity + i), dt)));
+    }
+    return i;
+}
+
+AVX_FUNCTION static int overlap_avx(const EntityStore *store, int slot, int first, int end, int *hits, int *hit_count)
+{
+    __m256 x = _mm256_set1_ps(store->position_x[slot]), y = _mm256_set1_ps(store->position_y[slot]);
+    __m256 w = _mm256_set1_ps(store->width[slot]),      h = _mm256_set1_ps(store->height[slot]);
+    __m256 half = _mm256_set1_ps(0.5f), zero = _mm256_setzero_ps();
+    __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m128i collision_mask = _mm_set1_epi32((int) store->collision_mask[slot]), zero_bits = _mm_setzero_si128();
+
+    int j = first;
+    for (; j + 8 <= end; j += 8)
+    {
+        __m256 x_distance = _mm256_sub_ps(_mm256_and_ps(_mm256_sub_ps(x, _mm256_loadu_ps(store->position_x + j)), abs_mask),
+                                          _mm256_mul_ps(_mm256_add_ps(w, _mm256_loadu_ps(store->width + j)), half));
+        __m256 y_distance = _mm256_sub_ps(_mm256_and_ps(_mm256_sub_ps(y, _mm256_loadu_ps(store->position_y + j)), abs_mask),
+                                          _mm256_mul_ps(_mm256_add_ps(h, _mm256_loadu_ps(store->height + j)), half));
+
+        __m256 hit = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(x_distance, zero, _CMP_LT_OQ),
+                                                 _mm256_cmp_ps(y_distance, zero, _CMP_LT_OQ)),
+                                   _mm256_cmp_ps(_mm256_loadu_ps(store->active + j), zero, _CMP_GT_OQ));
+
+        // AVX has no 256-bit integer ops, so the layer test is done as two SSE halves
+        __m128i low  = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*) (store->collision_layer + j)),     collision_mask), zero_bits);
+        __m128i high = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*) (store->collision_layer + j + 4)), collision_mask), zero_bits);
+        __m256 no_layer = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_castsi128_ps(low)), _mm_castsi128_ps(high), 1);
+        hit = _mm256_andnot_ps(no_layer, hit);
+
+        int mask = _mm256_movemask_ps(hit);
+        for (int lane = 0; mask != 0 && lane < 8; lane++)
+        {
+            if ((mask & (1 << lane)) && j + lane != slot) hits[(*hit_count)++] = j + lane;
+        }
+    }
+    return j;
+}
+#endif
+
+/**
+ STORE
+ */
+EntityStore::EntityStore()
+{
+    isa = detect_isa();
+    grow();
+}
+
+EntityStore::~EntityStore()
+{
+    free_array(position_x);
+    free_array(position_y);
+    free_array(velocity_x);
+    free_array(velocity_y);
+    free_array(width);
+    free_array(height);
+    free_array(active);
+    free_array(previous_x);
+    free_array(previous_y);
+    free_array(collision_layer);
+    free_array(collision_mask);
+    delete [] owner;
+}
+
+void EntityStore::grow()
+{
+    int new_capacity = capacity == 0 ? INITIAL_CAPACITY : capacity * 2;
+
+    position_x = regrow(position_x, count, new_capacity);
+    position_y = regrow(position_y, count, new_capacity);
+    velocity_x = regrow(velocity_x, count, new_capacity);
+    velocity_y = regrow(velocity_y, count, new_capacity);
+    width      = regrow(width,      count, new_capacity);
+    height     = regrow(height,     count, new_capacity);
+    active     = regrow(active,     count, new_capacity);
+    previous_x = regrow(previous_x, count, new_capacity);
+    previous_y = regrow(previous_y, count, new_capacity);
+    collision_layer = regrow(collision_layer, count, new_capacity);
+    collision_mask  = regrow(collision_mask,  count, new_capacity);
+
+    Entity **new_owner = new Entity*[new_capacity];
+    if (owner != NULL)
+    {
+        memcpy(new_owner, owner, sizeof(Entity*) * count);
+        delete [] owner;
+    }
+    owner = new_owner;
+
+    capacity = new_capacity;
+}
+
+int EntityStore::add(Entity *entity)
+{
+    int slot;
+    if (!free_slots.empty())
+    {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    else
+    {
+        if (count == capacity) grow();
+        slot = count++;
+    }
+
+    position_x[slot] = 0.0f;
+    position_y[slot] = 0.0f;
+    velocity_x[slot] = 0.0f;
+    velocity_y[slot] = 0.0f;
+    width[slot]      = 0.8f;
+    height[slot]     = 0.8f;
+    active[slot]     = 1.0f;
+    previous_x[slot] = 0.0f;
+    previous_y[slot] = 0.0f;
+    collision_layer[slot] = 0;
+    collision_mask[slot]  = 0;
+    owner[slot]      = entity;
+
+    return slot;
+}
+
+void EntityStore::remove(int slot)
+{
+    active[slot] = 0.0f;
+    owner[slot]  = NULL;
+    free_slots.push_back(slot);
+}
+
+void EntityStore::save_previous()
+{
+    memcpy(previous_x, position_x, sizeof(float) * count);
+    memcpy(previous_y, position_y, sizeof(float) * count);
+}
+
+void EntityStore::integrate_x(int first, int count, float delta_time)
+{
+    int end = first + count, i = first;
+#ifdef STORE_USE_X86
+    if (isa == ISA_AVX)      i = integrate_avx(position_x, velocity_x, i, end, delta_time);
+    else if (isa == ISA_SSE) i = integrate_sse(position_x, velocity_x, i, end, delta_time);
+#endif
+    integrate_scalar(position_x, velocity_x, i, end, delta_time);
+}
+
+void EntityStore::integrate_y(int first, int count, float delta_time)
+{
+    int end = first + count, i = first;
+#ifdef STORE_USE_X86
+    if (isa == ISA_AVX)      i = integrate_avx(position_y, velocity_y, i, end, delta_time);
+    else if (isa == ISA_SSE) i = integrate_sse(position_y, velocity_y, i, end, delta_time);
+#endif
+    integrate_scalar(position_y, velocity_y, i, end, delta_time);
+}
+
+int EntityStore::overlap(int slot, int first, int count, int *hits) const
+{
+    int end = first + count, j = first, hit_count = 0;
+    if (collision_mask[slot] == 0) return 0;
+
+#ifdef STORE_USE_X86
+    if (isa == ISA_AVX)      j = overlap_avx(this, slot, j, end, hits, &hit_count);
+    else if (isa == ISA_SSE) j = overlap_sse(this, slot, j, end, hits, &hit_count);
+#endif
+    return overlap_scalar(this, slot, j, end, hits, hit_count);
+}
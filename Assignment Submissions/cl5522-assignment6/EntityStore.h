@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+
+class Entity;
+
+/**
+ * The per-frame ("hot") half of every Entity, kept as one array per field.
+ *
+ * An entity only holds its slot number; its position, velocity, size and
+ * active flag live here, so a loop over a run of entities reads a few
+ * tightly packed floats instead of striding over whole Entity objects.
+ * The arrays are 32-byte aligned, and the kernels below pick SSE or AVX
+ * versions at startup depending on what the CPU supports.
+ *
+ * Freed slots are reused, most recently freed first, otherwise new ones are
+ * handed out in order. Entities created together (e.g.
+ * `new Entity[ENEMY_COUNT]`) therefore usually sit next to each other, and
+ * an array deleted and then created again gets its old slots back.
+ */
+class EntityStore {
+public:
+    enum Isa { ISA_SCALAR, ISA_SSE, ISA_AVX };
+
+    float *position_x  = 0;
+    float *position_y  = 0;
+    float *velocity_x  = 0;
+    float *velocity_y  = 0;
+    float *width       = 0;
+    float *height      = 0;
+    float *active      = 0; // 1.0f or 0.0f, so it can be tested alongside the rest
+
+    // Where everyone was before the current step, for drawing in between steps
+    float *previous_x  = 0;
+    float *previous_y  = 0;
+
+    // Collision filtering: slot j can hit slot i only if collision_layer[j] & collision_mask[i]
+    unsigned int *collision_layer = 0;
+    unsigned int *collision_mask  = 0;
+
+    // Cold: which entity sits in each slot
+    Entity **owner = 0;
+
+    EntityStore();
+    ~EntityStore();
+
+    int  add(Entity *entity);
+    void remove(int slot);
+
+    // Copies every position into previous_x/y; called at the start of each step
+    void save_previous();
+
+    // pos += vel * delta_time over slots [first, first + count)
+    void integrate_x(int first, int count, float delta_time);
+    void integrate_y(int first, int count, float delta_time);
+
+    // Writes the slots in [first, first + count) in `slot`'s mask whose box overlaps `slot`'s into hits, in order
+    int overlap(int slot, int first, int count, int *hits) const;
+
+    int const get_count()    const { return count;    };
+    int const get_capacity() const { return capacity; };
+    Isa const get_isa()      const { return isa;      };
+
+private:
+    int count    = 0;
+    int capacity = 0;
+    Isa isa;
+    
+    std::vector<int> free_slots;
+
+    void grow();
+};
@@ -0,0 +1,72 @@
+#include <math.h>
+#include "FramePacer.h"
+
+FramePacer::FramePacer(float target_fps)
+{
+    frequency = SDL_GetPerformanceFrequency();
+    set_target_fps(target_fps);
+}
+
+void FramePacer::set_target_fps(float target_fps)
+{
+    period   = target_fps > 0.0f ? (Uint64) (frequency / target_fps) : 0;
+    deadline = 0;
+}
+
+void FramePacer::wait()
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if (period > 0)
+    {
+        // Step 1: More than a frame behind (a hitch, a breakpoint...) means starting over, not catching up
+        if (deadline == 0 || now > deadline + period) deadline = now;
+
+        // Step 2: Sleep through most of what is left...
+        if (deadline > now)
+        {
+            Uint64 remaining_ms = (deadline - now) * 1000 / frequency;
+            if (remaining_ms > SPIN_MILLISECONDS) SDL_Delay((Uint32) (remaining_ms - SPIN_MILLISECONDS));
+        }
+
+        // Step 3: ...and spin through the rest
+        while ((now = SDL_GetPerformanceCounter()) < deadline) {}
+
+        deadline += period;
+    }
+
+    // Step 4: Remember how long this frame really took
+    if (last_wake != 0)
+    {
+        intervals[next_interval] = (float) (now - last_wake) * 1000.0f / (float) frequency;
+        next_interval = (next_interval + 1) % HISTORY;
+        if (interval_count < HISTORY) interval_count++;
+    }
+    last_wake = now;
+}
+
+void FramePacer::restart()
+{
+    deadline  = 0;
+    last_wake = 0;
+}
+
+FramePacer::Stats const FramePacer::get_stats() const
+{
+    Stats stats = { 0.0f, 0.0f, 0.0f, 0.0f };
+    stats.target_ms = period > 0 ? (float) period * 1000.0f / (float) frequency : 0.0f;
+    if (interval_count == 0) return stats;
+
+    for (int i = 0; i < interval_count; i++) stats.interval_avg_ms += intervals[i];
+    stats.interval_avg_ms /= interval_count;
+
+    for (int i = 0; i < interval_count; i++)
+    {
+        float jitter = fabsf(intervals[i] - stats.interval_avg_ms);
+        stats.jitter_avg_ms += jitter;
+        if (jitter > stats.jitter_max_ms) stats.jitter_max_ms = jitter;
+    }
+    stats.jitter_avg_ms /= interval_count;
+
+    return stats;
+}
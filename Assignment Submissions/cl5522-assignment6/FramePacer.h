@@ -0,0 +1,51 @@
+#pragma once
+#include <SDL.h>
+
+/**
+ * Holds the main loop to a target frame rate.
+ *
+ * wait() sleeps through most of what is left of the frame with SDL_Delay,
+ * which can overshoot by a millisecond or two, and spins on the performance
+ * counter for the last SPIN_MILLISECONDS. Deadlines are kept on a fixed grid
+ * (each one period after the last) so the rate doesn't drift, unless we fall
+ * more than a whole frame behind, in which case the grid starts over from now
+ * rather than racing to catch up.
+ *
+ * The time between successive wait()s is kept for the last HISTORY frames;
+ * jitter is how far those intervals stray from their average.
+ */
+class FramePacer {
+public:
+    static const int HISTORY = 120;
+    static const int SPIN_MILLISECONDS = 2;
+
+    struct Stats
+    {
+        float target_ms;       // 0 when uncapped
+        float interval_avg_ms;
+        float jitter_avg_ms;
+        float jitter_max_ms;
+    };
+
+    FramePacer(float target_fps);
+
+    // 0 or less turns the cap off; wait() then only measures
+    void set_target_fps(float target_fps);
+
+    void wait();
+
+    // The loop waited some other way (e.g. blocking for events), so start the grid over
+    void restart();
+
+    Stats const get_stats() const;
+
+private:
+    Uint64 frequency;
+    Uint64 period   = 0;   // in counter ticks
+    Uint64 deadline = 0;
+    Uint64 last_wake = 0;
+
+    float intervals[HISTORY];  // in milliseconds
+    int interval_count = 0;
+    int next_interval  = 0;
+};
@@ -0,0 +1,148 @@
+#define NUMBER_OF_TEXTURES 1 // to be generated, that is
+#define LEVEL_OF_DETAIL 0    // base image level; Level n is the nth mipmap reduction image
+#define TEXTURE_BORDER 0     // this value MUST be zero
+
+#include "GLRenderDevice.h"
+
+bool GLRenderDevice::open(const char *title, int width, int height)
+{
+    window = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, SDL_WINDOW_OPENGL);
+    if (window == NULL) return false;
+
+    context = SDL_GL_CreateContext(window);
+    if (context == NULL) return false;
+    SDL_GL_MakeCurrent(window, context);
+
+#ifdef _WINDOWS
+    glewInit();
+#endif
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    return true;
+}
+
+void GLRenderDevice::close()
+{
+    if (context != NULL) SDL_GL_DeleteContext(context);
+    if (window  != NULL) SDL_DestroyWindow(window);
+    context = NULL;
+    window  = NULL;
+}
+
+void GLRenderDevice::set_viewport(int x, int y, int width, int height)
+{
+    glViewport(x, y, width, height);
+}
+
+void GLRenderDevice::set_clear_colour(float red, float green, float blue, float alpha)
+{
+    glClearColor(red, green, blue, alpha);
+}
+
+GLuint const GLRenderDevice::get_location(VertexAttribute attribute) const
+{
+    switch (attribute)
+    {
+        case VERTEX_POSITION:           return program->positionAttribute;
+        case VERTEX_TEXTURE_COORDINATE: return program->texCoordAttribute;
+        default:                        return program->spriteIndexAttribute;
+    }
+}
+
+void GLRenderDevice::apply_clear()
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void GLRenderDevice::apply_program(ShaderProgram *program)
+{
+    // Arrays are switched on per program, so the old one's go off first
+    for (int attribute = 0; this->program != NULL && attribute < VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        if (is_array_enabled[attribute]) glDisableVertexAttribArray(get_location((VertexAttribute) attribute));
+        is_array_enabled[attribute] = false;
+    }
+
+    this->program = program;
+    glUseProgram(program->programID);
+}
+
+void GLRenderDevice::apply_texture(GLuint texture_id)
+{
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+}
+
+void GLRenderDevice::apply_sprite_sheet(int cols, int rows)
+{
+    program->SetSpriteSheet(cols, rows);
+}
+
+void GLRenderDevice::apply_sprite_index(int index)
+{
+    program->SetSpriteIndex(index);
+}
+
+void GLRenderDevice::apply_model_matrix(const glm::mat4 &matrix)
+{
+    program->SetModelMatrix(matrix);
+}
+
+void GLRenderDevice::apply_vertex_array(VertexAttribute attribute, const float *data, int components)
+{
+    GLuint location = get_location(attribute);
+
+    if (data == NULL)
+    {
+        if (is_array_enabled[attribute]) glDisableVertexAttribArray(location);
+        is_array_enabled[attribute] = false;
+        return;
+    }
+
+    glVertexAttribPointer(location, components, GL_FLOAT, false, 0, data);
+    if (!is_array_enabled[attribute]) glEnableVertexAttribArray(location);
+    is_array_enabled[attribute] = true;
+}
+
+void GLRenderDevice::apply_draw(int vertex_count)
+{
+    glDrawArrays(GL_TRIANGLES, 0, vertex_count);
+}
+
+void GLRenderDevice::apply_present()
+{
+    SDL_GL_SwapWindow(window);
+}
+
+GLuint GLRenderDevice::apply_create_texture(int width, int height, const unsigned char *pixels)
+{
+    // Generating and binding a texture ID to the image
+    GLuint texture_id;
+    glGenTextures(NUMBER_OF_TEXTURES, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    // Filter modes
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // Wrapping modes
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    return texture_id;
+}
+
+void GLRenderDevice::apply_load_program(ShaderProgram *program, const char *vertex_shader_file, const char *fragment_shader_file)
+{
+    program->Load(vertex_shader_file, fragment_shader_file);
+}
+
+void GLRenderDevice::apply_view_matrix(ShaderProgram *program, const glm::mat4 &matrix)
+{
+    program->SetViewMatrix(matrix);
+}
+
+void GLRenderDevice::apply_projection_matrix(ShaderProgram *program, const glm::mat4 &matrix)
+{
+    program->SetProjectionMatrix(matrix);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "RenderDevice.h"
+
+// Draws through OpenGL, with client-side vertex arrays, into a window it opens
+class GLRenderDevice : public RenderDevice {
+private:
+    SDL_Window *window = NULL;
+    SDL_GLContext context = NULL;
+
+    ShaderProgram *program = NULL;
+    bool is_array_enabled[VERTEX_ATTRIBUTE_COUNT] = { false, false, false };
+
+    GLuint const get_location(VertexAttribute attribute) const;
+
+protected:
+    void apply_clear() override;
+    void apply_program(ShaderProgram *program) override;
+    void apply_texture(GLuint texture_id) override;
+    void apply_sprite_sheet(int cols, int rows) override;
+    void apply_sprite_index(int index) override;
+    void apply_model_matrix(const glm::mat4 &matrix) override;
+    void apply_vertex_array(VertexAttribute attribute, const float *data, int components) override;
+    void apply_draw(int vertex_count) override;
+
+    GLuint apply_create_texture(int width, int height, const unsigned char *pixels) override;
+    void apply_load_program(ShaderProgram *program, const char *vertex_shader_file, const char *fragment_shader_file) override;
+    void apply_view_matrix(ShaderProgram *program, const glm::mat4 &matrix) override;
+    void apply_projection_matrix(ShaderProgram *program, const glm::mat4 &matrix) override;
+    void apply_present() override;
+
+public:
+    // Opens the window with its GL context, blending on. False if either can't be had;
+    // SDL_GetError() says why. Nothing else here may be called until this has worked
+    bool open(const char *title, int width, int height);
+
+    // Before SDL_Quit(); does nothing if open() never worked
+    void close();
+
+    void set_viewport(int x, int y, int width, int height);
+    void set_clear_colour(float red, float green, float blue, float alpha);
+};
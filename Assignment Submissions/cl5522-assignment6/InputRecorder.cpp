@@ -0,0 +1,130 @@
+#define _CRT_SECURE_NO_WARNINGS
+#define LOG(argument) std::cout << argument << '\n'
+#define STEP_SIZE 6 // bytes per recorded step
+
+#include <iostream>
+#include <string.h>
+#include "InputRecorder.h"
+
+const char RECORDING_MAGIC[] = { 'A', 'I', 'R', 'P' };
+
+InputRecorder::~InputRecorder()
+{
+    stop();
+}
+
+bool InputRecorder::start_recording(const char *filepath)
+{
+    stop();
+
+    file = fopen(filepath, "wb");
+    if (file == NULL)
+    {
+        LOG("Unable to open " << filepath << " for recording.");
+        return false;
+    }
+
+    fwrite(RECORDING_MAGIC, 1, sizeof(RECORDING_MAGIC), file);
+    unsigned int version = VERSION;
+    fwrite(&version, sizeof(version), 1, file);
+
+    mode = RECORDING;
+    step = 0;
+    return true;
+}
+
+bool InputRecorder::start_replay(const char *filepath)
+{
+    stop();
+
+    FILE *replay_file = fopen(filepath, "rb");
+    if (replay_file == NULL)
+    {
+        LOG("Unable to open " << filepath << " for replay.");
+        return false;
+    }
+
+    // The whole recording is read up front so playback never touches the disk
+    char magic[sizeof(RECORDING_MAGIC)];
+    unsigned int version = 0;
+    bool valid = fread(magic, 1, sizeof(magic), replay_file) == sizeof(magic) &&
+                 fread(&version, sizeof(version), 1, replay_file) == 1 &&
+                 memcmp(magic, RECORDING_MAGIC, sizeof(magic)) == 0 &&
+                 version == VERSION;
+
+    if (!valid)
+    {
+        LOG(filepath << " is not a recording this build can play.");
+        fclose(replay_file);
+        return false;
+    }
+
+    unsigned char buffer[4096];
+    size_t read_count;
+    while ((read_count = fread(buffer, 1, sizeof(buffer), replay_file)) > 0)
+    {
+        replay_data.insert(replay_data.end(), buffer, buffer + read_count);
+    }
+    fclose(replay_file);
+
+    mode = REPLAYING;
+    replay_offset = 0;
+    step = 0;
+    first_divergence = -1;
+    return true;
+}
+
+void InputRecorder::stop()
+{
+    if (file != NULL)
+    {
+        fclose(file);
+        file = NULL;
+    }
+
+    if (mode == REPLAYING)
+    {
+        if (first_divergence < 0) LOG("Replay finished after " << step << " steps with no divergence.");
+        else                      LOG("Replay diverged at step " << first_divergence << ".");
+    }
+
+    replay_data.clear();
+    mode = OFF;
+}
+
+void InputRecorder::record(unsigned short buttons, unsigned int state_hash)
+{
+    if (mode != RECORDING) return;
+
+    unsigned char entry[STEP_SIZE];
+    memcpy(entry, &buttons, 2);
+    memcpy(entry + 2, &state_hash, 4);
+    fwrite(entry, 1, STEP_SIZE, file);
+
+    step++;
+}
+
+bool InputRecorder::next(unsigned short *buttons, unsigned int *expected_hash)
+{
+    if (mode != REPLAYING || replay_offset + STEP_SIZE > replay_data.size()) return false;
+
+    memcpy(buttons, &replay_data[replay_offset], 2);
+    memcpy(expected_hash, &replay_data[replay_offset + 2], 4);
+    replay_offset += STEP_SIZE;
+
+    return true;
+}
+
+void InputRecorder::verify(unsigned int state_hash, unsigned int expected_hash)
+{
+    if (mode != REPLAYING) return;
+
+    // Only the first mismatch is interesting; everything after it diverges too
+    if (state_hash != expected_hash && first_divergence < 0)
+    {
+        first_divergence = step;
+        LOG("Replay diverged at step " << step << ": expected " << expected_hash << ", got " << state_hash);
+    }
+
+    step++;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdio.h>
+#include <vector>
+
+/**
+ * Everything the player can do during one fixed step, packed into bits.
+ * Held keys are set for every step they are down; presses (fire, advance,
+ * save/load) only for the first step after they happen.
+ */
+enum InputButton
+{
+    INPUT_THRUST_UP      = 1 << 0,
+    INPUT_THRUST_DOWN    = 1 << 1,
+    INPUT_THRUST_LEFT    = 1 << 2,
+    INPUT_THRUST_RIGHT   = 1 << 3,
+    INPUT_ROTATE_COUNTER = 1 << 4,
+    INPUT_ROTATE_CLOCK   = 1 << 5,
+    INPUT_FIRE           = 1 << 6,
+    INPUT_ADVANCE        = 1 << 7,
+    INPUT_QUICK_SAVE     = 1 << 8,
+    INPUT_QUICK_LOAD     = 1 << 9,
+    INPUT_RETRY          = 1 << 10,
+    INPUT_REWIND         = 1 << 11
+};
+
+// Buttons that fire once per key press rather than while held
+const unsigned short INPUT_PRESSES = INPUT_FIRE | INPUT_ADVANCE | INPUT_QUICK_SAVE | INPUT_QUICK_LOAD | INPUT_RETRY;
+
+/**
+ * Writes the buttons of every fixed step to a file, together with a hash of
+ * the game state right after that step, and plays such a file back.
+ *
+ * File layout: "AIRP", a version number, then six bytes per step
+ * (two bytes of buttons, four bytes of hash).
+ */
+class InputRecorder {
+private:
+    enum Mode { OFF, RECORDING, REPLAYING };
+
+    Mode mode = OFF;
+    FILE *file = NULL;
+
+    std::vector<unsigned char> replay_data;
+    size_t replay_offset = 0;
+
+    int step = 0;
+    int first_divergence = -1;
+
+public:
+    static const unsigned int VERSION = 1;
+
+    ~InputRecorder();
+
+    bool start_recording(const char *filepath);
+    bool start_replay(const char *filepath);
+    void stop();
+
+    void record(unsigned short buttons, unsigned int state_hash);
+    bool next(unsigned short *buttons, unsigned int *expected_hash);
+    void verify(unsigned int state_hash, unsigned int expected_hash);
+
+    bool const is_recording() const { return mode == RECORDING; };
+    bool const is_replaying() const { return mode == REPLAYING; };
+    int  const get_step()     const { return step; };
+    int  const get_first_divergence() const { return first_divergence; };
+};
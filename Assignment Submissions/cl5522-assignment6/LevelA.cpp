@@ -1,8 +1,11 @@
 #include "LevelA.h"
 #include "Utility.h"
+#include "UpdateSystem.h"
+#include <stdio.h>
 
 #define LEVEL_WIDTH 14
 #define LEVEL_HEIGHT 8
+#define PARTICLE_CAPACITY 4096
 
 const char GUARD_FILEPATH[] = "assets/asteroid.png";
 const char SPRITESHEET_FILEPATH[] = "assets/starship.png";
@@ -24,12 +27,7 @@ unsigned int LEVEL_DATA[] =
 
 LevelA::~LevelA()
 {
-    delete [] this->state.enemies;
-    delete    this->state.player;
-    delete    this->state.map;
-    for (Entity* ele : state.bullet_vector) {
-        delete ele;
-    }
+    // Entities, lasers and particles all go with the scene's arena
     Mix_FreeChunk(this->state.jump_sfx);
     Mix_FreeMusic(this->state.bgm);
 }
@@ -44,7 +42,7 @@ void LevelA::initialise()
 
 
     // Existing
-    state.player = new Entity();
+    state.player = arena.create<Entity>();
     state.player->set_entity_type(PLAYER);
     state.player->set_position(glm::vec3(5.0f, -2.0f, 0.0f));
     state.player->set_movement(glm::vec3(0.0f));
@@ -61,6 +59,7 @@ void LevelA::initialise()
 
     //thrusting
     state.player->thrusting_power = 5.0f;
+    registry.add(state.player);
     
     /**
      Enemies' stuff */
@@ -81,7 +80,11 @@ void LevelA::initialise()
     // */
     GLuint enemy_texture_id = Utility::load_texture(GUARD_FILEPATH);
 
-    state.enemies = new Entity[ENEMY_COUNT];
+    // Sparks and debris share the asteroid texture so they all go out in one draw
+    state.particles = arena.create<ParticleSystem>(PARTICLE_CAPACITY, enemy_texture_id);
+
+    state.enemies = arena.create_array<Entity>(ENEMY_COUNT);
+    number_of_enemies = ENEMY_COUNT;
     for (int i = 0; i < ENEMY_COUNT; ++i) {
         state.enemies[i].set_entity_type(ENEMY);
         state.enemies[i].set_ai_type(GUARD);
@@ -99,6 +102,12 @@ void LevelA::initialise()
     state.enemies[2].set_position(glm::vec3(4.0f, -5.0f, 0.0f));
     state.enemies[3].set_position(glm::vec3(8.0f, -6.0f, 0.0f));
     state.enemies[4].set_position(glm::vec3(10.0f, 0.0f, 0.0f));
+
+    for (int i = 0; i < ENEMY_COUNT; ++i) registry.add(&state.enemies[i]);
+    reserve_bullets(SCENE_MAX_BULLETS);
+
+    // At worst, the player touches every enemy, every enemy the player, and every laser one enemy
+    contacts.reserve(2 * ENEMY_COUNT + SCENE_MAX_BULLETS);
     
     /**
      BGM and SFX
@@ -113,56 +122,62 @@ void LevelA::initialise()
    
 }
 
-void LevelA::update(float delta_time) { 
-    int len_bullet_vector = state.bullet_vector.size();
-
-    for (int i = 0; i < ENEMY_COUNT; ++i) {
-        if (state.enemies[i].get_active_state()) {
-            enemies_active = true;
-        }
-    }
-
-
+void LevelA::update(float delta_time) {
     if (!state.player->get_active_state()) {
         state.next_scene_id = 5;
         return;
     }
 
-    if (!enemies_active) {
+    if (registry.get_active_count(ENEMY) == 0) {
         state.next_scene_id = 2;
         return;
     }
 
-    enemies_active = false;
+    // Damage is dealt once per pair of entities per step, whoever's update finds the touch
+    contacts.begin_step();
+    ai_scheduler.begin_step();
+    visibility.begin_step(state.map, state.player->get_position());
 
-    this->state.player->update(delta_time, state.player, state.enemies, this->ENEMY_COUNT); 
+    update_entities(&registry, PLAYER, &update_batch, delta_time, state.player, state.enemies, this->ENEMY_COUNT, &contacts);
 
-    for (int i = 0; i < ENEMY_COUNT; ++i) {
-        state.enemies[i].update(delta_time, state.player, state.player, 1);
+    // update_batch is left holding everyone updated, including whoever switched off
+    update_entities(&registry, ENEMY, &update_batch, delta_time, state.player, state.player, 1, &contacts, &ai_scheduler, &visibility);
+    for (Entity *enemy : update_batch) {
+        // Out of lives this step: break the asteroid up
+        if (!enemy->get_active_state()) {
+            state.particles->emit(enemy->get_position(), 40, 3.0f, 0.8f, 0.2f);
+        }
     }
-    
-    for (int i = 0; i < len_bullet_vector; ++i) {
-        this->state.bullet_vector[i]->update(delta_time, state.player, state.enemies, this->ENEMY_COUNT);
-        if (this->state.bullet_vector[i]->calc_distance(state.player) > 4.0f) {
-            state.bullet_vector[i]->deactivate();
+
+    update_entities(&registry, GREEN_LASER, &update_batch, delta_time, state.player, state.enemies, this->ENEMY_COUNT, &contacts);
+    for (Entity *laser : update_batch) {
+        // Lasers only switch themselves off when they hit something
+        if (!laser->get_active_state()) {
+            state.particles->emit(laser->get_position(), 8, 2.0f, 0.3f, 0.1f);
+        }
+        if (laser->calc_distance(state.player) > 4.0f) {
+            laser->deactivate();
         }
     }
 
+    remove_inactive_bullets();
+
+    state.particles->update(delta_time);
+
     //if (this->state.player->get_position().y < -10.0f) state.next_scene_id = 2;
     //std::cout << state.enemies[0].get_position().x << std::endl;
 
 }
 
-void LevelA::render(ShaderProgram *program)
+void LevelA::render(ShaderProgram *program, RenderQueue *queue, float alpha)
 {
     int x = state.player->get_lives();
-    std::string c_lives = std::to_string(x);
-    Utility::draw_text(program, text_texture_id, c_lives, 0.3f, 0.1f, glm::vec3(1.0f, -1.0f, 0.0f));
-    int len_bullet_vector = state.bullet_vector.size();
-    for (int i = 0; i < len_bullet_vector; ++i) {
-        this->state.bullet_vector[i]->render(program);
-    }
-    for (int i = 0; i < ENEMY_COUNT; i++) this->state.enemies[i].render(program);
-    this->state.player->render(program);
+    char c_lives[16];
+    snprintf(c_lives, sizeof(c_lives), "%d", x);
+    Utility::draw_text(program, queue, text_texture_id, c_lives, 0.3f, 0.1f, glm::vec3(1.0f, -1.0f, 0.0f));
+    for (Entity *laser : registry.get_active(GREEN_LASER)) laser->render(program, queue, alpha);
+    for (Entity *enemy : registry.get_active(ENEMY)) enemy->render(program, queue, alpha);
+    state.particles->render(program, queue, alpha);
+    this->state.player->render(program, queue, alpha);
 
 }
@@ -10,6 +10,7 @@ public:
 
 	void initialise() override;
 	void update(float delta_time) override;
-	void render(ShaderProgram* program) override;
+	void render(ShaderProgram *program, RenderQueue *queue, float alpha) override;
+	bool const is_static() const override { return true; };
 
 };
\ No newline at end of file
@@ -59,23 +59,68 @@ void Map::build()
     this->bottom_bound = -(this->tile_size * this->height) + (this->tile_size / 2);
 }
 
-void Map::render(ShaderProgram *program)
+void Map::set_tile(int x, int y, unsigned int tile)
 {
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    program->SetModelMatrix(model_matrix);
+    this->level_data[y * this->width + x] = tile;
     
-    glUseProgram(program->programID);
+    // The mesh is baked, so bake it again
+    this->vertices.clear();
+    this->texture_coordinates.clear();
+    this->build();
+}
+
+void Map::render(ShaderProgram *program, RenderQueue *queue)
+{
+    // The tile UVs are baked in build(), so the shader should pass them through
+    // untouched, which the command's default 1x1 sheet does
+    RenderCommand *command = queue->add(program, RENDER_LAYER_MAP, this->texture_id);
+    command->vertices            = this->vertices.data();
+    command->texture_coordinates = this->texture_coordinates.data();
+    command->vertex_count        = (int) this->vertices.size() / 2;
+}
+
+bool const Map::raycast(glm::vec3 from, glm::vec3 to, glm::vec3 *hit) const
+{
+    // Step 1: Into tile units, where tile (x, y) covers [x, x + 1) x [y, y + 1) and y counts down
+    float start_x = from.x / this->tile_size + 0.5f, start_y = -from.y / this->tile_size + 0.5f;
+    float end_x   = to.x   / this->tile_size + 0.5f, end_y   = -to.y   / this->tile_size + 0.5f;
+    float delta_x = end_x - start_x, delta_y = end_y - start_y;
     
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, this->vertices.data());
-    glEnableVertexAttribArray(program->positionAttribute);
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, this->texture_coordinates.data());
-    glEnableVertexAttribArray(program->texCoordAttribute);
+    int tile_x = (int) floor(start_x), tile_y = (int) floor(start_y);
+    int end_tile_x = (int) floor(end_x), end_tile_y = (int) floor(end_y);
+    int step_x = delta_x > 0 ? 1 : -1, step_y = delta_y > 0 ? 1 : -1;
     
-    glBindTexture(GL_TEXTURE_2D, this->texture_id);
+    // Step 2: How far along the line (0 at from, 1 at to) it next crosses a column and a row,
+    //         and how far it goes between crossings
+    float next_x = delta_x > 0 ? (tile_x + 1 - start_x) / delta_x : delta_x < 0 ? (tile_x - start_x) / delta_x : INFINITY;
+    float next_y = delta_y > 0 ? (tile_y + 1 - start_y) / delta_y : delta_y < 0 ? (tile_y - start_y) / delta_y : INFINITY;
+    float across_x = delta_x != 0 ? fabs(1.0f / delta_x) : INFINITY;
+    float across_y = delta_y != 0 ? fabs(1.0f / delta_y) : INFINITY;
     
-    glDrawArrays(GL_TRIANGLES, 0, (int) this->vertices.size() / 2);
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
+    // Step 3: Walk the tiles the line passes through, in order, until one is solid
+    float t = 0.0f;
+    while (true)
+    {
+        if (is_solid_tile(tile_x, tile_y)) {
+            if (hit != NULL) *hit = from + (to - from) * t;
+            return true;
+        }
+        if (tile_x == end_tile_x && tile_y == end_tile_y) return false;
+        
+        if (next_x < next_y) {
+            t = next_x;
+            next_x += across_x;
+            tile_x += step_x;
+        }
+        else {
+            t = next_y;
+            next_y += across_y;
+            tile_y += step_y;
+        }
+        
+        // Only rounding gets us here without passing the end tile, but it can
+        if (t > 1.0f) return false;
+    }
 }
 
 bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_y)
@@ -12,6 +12,7 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "RenderQueue.h"
 
 class Map {
 private:
@@ -35,9 +36,24 @@ public:
     tile_count_x, int tile_count_y);
     
     void build();
-    void render(ShaderProgram *program);
+    void render(ShaderProgram *program, RenderQueue *queue);
     bool is_solid(glm::vec3 position, float *penetration_x, float *penetration_y);
     
+    // Tiles count from the top left, x to the right and y down; 0 is empty
+    unsigned int const get_tile(int x, int y) const { return this->level_data[y * this->width + x]; }
+    bool const is_walkable(int x, int y) const { return x >= 0 && x < this->width && y >= 0 && y < this->height && get_tile(x, y) == 0; }
+    bool const is_solid_tile(int x, int y) const { return x >= 0 && x < this->width && y >= 0 && y < this->height && get_tile(x, y) != 0; }
+    void set_tile(int x, int y, unsigned int tile);
+    
+    // The centre of a tile in the world, and the tile a world position falls in
+    glm::vec3 const get_tile_centre(int x, int y) const { return glm::vec3(x * this->tile_size, -y * this->tile_size, 0.0f); }
+    int const get_tile_x(float world_x) const { return (int) floor((world_x + (this->tile_size / 2)) / this->tile_size); }
+    int const get_tile_y(float world_y) const { return (int) floor((-world_y + (this->tile_size / 2)) / this->tile_size); }
+    
+    // Whether the straight line from `from` to `to` passes through a solid tile; if so, hit is
+    // where it first does. Off the map counts as open, the same as is_solid()
+    bool const raycast(glm::vec3 from, glm::vec3 to, glm::vec3 *hit = NULL) const;
+    
     // Getters
     int const get_width()  const  { return this->width;  }
     int const get_height() const  { return this->height; }
@@ -0,0 +1,29 @@
+#pragma once
+#include "RenderDevice.h"
+
+/**
+ * Draws nothing and needs no window or GL context; RenderDevice still
+ * counts every call, so this is what to render into to measure a scene
+ * headless. Textures are only numbered, so they still bind as different
+ * textures.
+ */
+class NullRenderDevice : public RenderDevice {
+private:
+    GLuint texture_count = 0;
+
+protected:
+    void apply_clear() override {};
+    void apply_program(ShaderProgram * /* program */) override {};
+    void apply_texture(GLuint /* texture_id */) override {};
+    void apply_sprite_sheet(int /* cols */, int /* rows */) override {};
+    void apply_sprite_index(int /* index */) override {};
+    void apply_model_matrix(const glm::mat4 & /* matrix */) override {};
+    void apply_vertex_array(VertexAttribute /* attribute */, const float * /* data */, int /* components */) override {};
+    void apply_draw(int /* vertex_count */) override {};
+
+    GLuint apply_create_texture(int /* width */, int /* height */, const unsigned char * /* pixels */) override { return ++texture_count; };
+    void apply_load_program(ShaderProgram * /* program */, const char * /* vertex_shader_file */, const char * /* fragment_shader_file */) override {};
+    void apply_view_matrix(ShaderProgram * /* program */, const glm::mat4 & /* matrix */) override {};
+    void apply_projection_matrix(ShaderProgram * /* program */, const glm::mat4 & /* matrix */) override {};
+    void apply_present() override {};
+};
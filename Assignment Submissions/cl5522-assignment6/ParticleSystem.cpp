@@ -0,0 +1,179 @@
+#define GL_SILENCE_DEPRECATION
+#define PARTICLE_DRAG 1.5f   // fraction of velocity lost per second
+#define TWO_PI 6.2831853f
+
+#include <stdlib.h>
+#include "ParticleSystem.h"
+#include "AllocationTracker.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define PARTICLES_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+static float *allocate_floats(int count)
+{
+    float *floats = (float*) AllocationTracker::allocate_aligned(sizeof(float) * count, 16);
+    for (int i = 0; i < count; i++) floats[i] = 0.0f;
+    return floats;
+}
+
+static void free_floats(float *floats)
+{
+    AllocationTracker::release_aligned(floats);
+}
+
+ParticleSystem::ParticleSystem(int capacity, GLuint texture_id)
+{
+    // Round up to a multiple of 4 so the SIMD loop never has a leftover tail
+    this->capacity = (capacity + 3) & ~3;
+    this->texture_id = texture_id;
+
+    position_x = allocate_floats(this->capacity);
+    position_y = allocate_floats(this->capacity);
+    velocity_x = allocate_floats(this->capacity);
+    velocity_y = allocate_floats(this->capacity);
+    lifetime   = allocate_floats(this->capacity);
+    size       = allocate_floats(this->capacity);
+    shrink     = allocate_floats(this->capacity);
+
+    vertices            = allocate_floats(this->capacity * 12);
+    texture_coordinates = allocate_floats(this->capacity * 12);
+
+    // Every particle is the same textured quad, so the UVs never change
+    static const float quad_coords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
+    for (int i = 0; i < this->capacity; i++)
+    {
+        for (int j = 0; j < 12; j++) texture_coordinates[i * 12 + j] = quad_coords[j];
+    }
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    free_floats(position_x);
+    free_floats(position_y);
+    free_floats(velocity_x);
+    free_floats(velocity_y);
+    free_floats(lifetime);
+    free_floats(size);
+    free_floats(shrink);
+    free_floats(vertices);
+    free_floats(texture_coordinates);
+}
+
+float ParticleSystem::random_float()
+{
+    // Our own LCG, so the same hits always make the same debris
+    seed = seed * 1664525u + 1013904223u;
+    return (float) (seed >> 8) / 16777216.0f;
+}
+
+void ParticleSystem::emit(glm::vec3 position, int count, float speed, float lifetime, float size)
+{
+    for (int n = 0; n < count && live_count < capacity; n++)
+    {
+        int i = live_count++;
+
+        float angle = random_float() * TWO_PI;
+        float power = speed * (0.5f + 0.5f * random_float());
+
+        position_x[i] = position.x;
+        position_y[i] = position.y;
+        velocity_x[i] = glm::cos(angle) * power;
+        velocity_y[i] = glm::sin(angle) * power;
+
+        this->lifetime[i] = lifetime * (0.5f + 0.5f * random_float());
+        this->size[i]     = size;
+        shrink[i]         = size / this->lifetime[i];
+    }
+}
+
+void ParticleSystem::update(float delta_time)
+{
+    step_time = delta_time;
+
+    // Step 1: Integrate everyone that is alive, four at a time
+    int padded_count = (live_count + 3) & ~3;
+    float drag = 1.0f - PARTICLE_DRAG * delta_time;
+
+#ifdef PARTICLES_USE_SSE
+    __m128 dt      = _mm_set1_ps(delta_time);
+    __m128 damping = _mm_set1_ps(drag);
+
+    for (int i = 0; i < padded_count; i += 4)
+    {
+        __m128 vx = _mm_mul_ps(_mm_load_ps(velocity_x + i), damping);
+        __m128 vy = _mm_mul_ps(_mm_load_ps(velocity_y + i), damping);
+
+        _mm_store_ps(velocity_x + i, vx);
+        _mm_store_ps(velocity_y + i, vy);
+        _mm_store_ps(position_x + i, _mm_add_ps(_mm_load_ps(position_x + i), _mm_mul_ps(vx, dt)));
+        _mm_store_ps(position_y + i, _mm_add_ps(_mm_load_ps(position_y + i), _mm_mul_ps(vy, dt)));
+        _mm_store_ps(lifetime + i,   _mm_sub_ps(_mm_load_ps(lifetime + i), dt));
+        _mm_store_ps(size + i,       _mm_sub_ps(_mm_load_ps(size + i), _mm_mul_ps(_mm_load_ps(shrink + i), dt)));
+    }
+#else
+    for (int i = 0; i < padded_count; i++)
+    {
+        velocity_x[i] *= drag;
+        velocity_y[i] *= drag;
+        position_x[i] += velocity_x[i] * delta_time;
+        position_y[i] += velocity_y[i] * delta_time;
+        lifetime[i]   -= delta_time;
+        size[i]       -= shrink[i] * delta_time;
+    }
+#endif
+
+    // Step 2: Retire the dead by moving the last live particle into their slot
+    int i = 0;
+    while (i < live_count)
+    {
+        if (lifetime[i] > 0.0f)
+        {
+            i++;
+            continue;
+        }
+
+        int last = --live_count;
+        position_x[i] = position_x[last];
+        position_y[i] = position_y[last];
+        velocity_x[i] = velocity_x[last];
+        velocity_y[i] = velocity_y[last];
+        lifetime[i]   = lifetime[last];
+        size[i]       = size[last];
+        shrink[i]     = shrink[last];
+    }
+}
+
+void ParticleSystem::render(ShaderProgram *program, RenderQueue *queue, float alpha)
+{
+    if (live_count == 0) return;
+
+    // The last update moved everyone by their (current) velocity, so backing off
+    // part of it puts them where they were partway through that step
+    float behind = (1.0f - alpha) * step_time;
+
+    // Step 1: Build one quad per particle, already in world space
+    for (int i = 0; i < live_count; i++)
+    {
+        float half = size[i] / 2.0f;
+        float x = position_x[i] - velocity_x[i] * behind;
+        float y = position_y[i] - velocity_y[i] * behind;
+        float left   = x - half, right = x + half;
+        float bottom = y - half, top   = y + half;
+
+        float *quad = vertices + i * 12;
+        quad[0] = left;  quad[1]  = bottom;
+        quad[2] = right; quad[3]  = bottom;
+        quad[4] = right; quad[5]  = top;
+        quad[6] = left;  quad[7]  = bottom;
+        quad[8] = right; quad[9]  = top;
+        quad[10] = left; quad[11] = top;
+    }
+
+    // Step 2: And draw the whole pool in one go
+    RenderCommand *command = queue->add(program, RENDER_LAYER_EFFECTS, texture_id);
+    command->vertices            = vertices;
+    command->texture_coordinates = texture_coordinates;
+    command->vertex_count        = live_count * 6;
+}
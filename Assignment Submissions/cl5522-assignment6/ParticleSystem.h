@@ -0,0 +1,66 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+#include "RenderQueue.h"
+
+/**
+ * A fixed-size pool of particles (laser sparks, asteroid debris...).
+ *
+ * Every attribute lives in its own array so update() can push four particles
+ * through SSE at a time, and live particles are always packed at the front
+ * of the arrays so render() can draw all of them with a single command.
+ * Nothing is allocated after the constructor; emit() just drops particles
+ * when the pool is full.
+ */
+class ParticleSystem {
+private:
+    int capacity;
+    int live_count = 0;
+
+    // Structure of arrays, 16-byte aligned
+    float *position_x;
+    float *position_y;
+    float *velocity_x;
+    float *velocity_y;
+    float *lifetime;
+    float *size;
+    float *shrink;
+
+    // Six vertices per particle, written every frame / filled once
+    float *vertices;
+    float *texture_coordinates;
+
+    GLuint texture_id;
+    unsigned int seed = 1;
+
+    // Length of the last update(), to draw particles partway back along it
+    float step_time = 0.0f;
+
+    float random_float();
+
+public:
+    ParticleSystem(int capacity, GLuint texture_id);
+    ~ParticleSystem();
+
+    // The pool arrays are owned, so a copy would free them twice
+    ParticleSystem(const ParticleSystem &) = delete;
+    ParticleSystem &operator=(const ParticleSystem &) = delete;
+
+    void emit(glm::vec3 position, int count, float speed, float lifetime, float size);
+    void update(float delta_time);
+    void render(ShaderProgram *program, RenderQueue *queue, float alpha);
+    void clear() { live_count = 0; };
+
+    int const get_capacity()   const { return capacity;   };
+    int const get_live_count() const { return live_count; };
+};
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <chrono>
+#include "PathService.h"
+#include "AllocationTracker.h"
+
+PathService::PathService(Map *map, int worker_count, int max_expansions) : graph(map)
+{
+    this->map = map;
+    this->max_expansions = max_expansions;
+    is_stopping = false;
+
+    for (int i = 0; i < worker_count; i++) workers.push_back(std::thread(&PathService::work, this));
+}
+
+PathService::~PathService()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_lock);
+        is_stopping = true;
+    }
+    has_work.notify_all();
+
+    for (std::thread &worker : workers) worker.join();
+}
+
+/**
+ REQUESTS
+ */
+int PathService::request(TilePosition start, TilePosition goal)
+{
+    std::lock_guard<std::mutex> lock(queue_lock);
+
+    int ticket;
+    if (!free_jobs.empty())
+    {
+        ticket = free_jobs.back();
+        free_jobs.pop_back();
+    }
+    else
+    {
+        ticket = (int) jobs.size();
+        jobs.push_back(Job());
+    }
+
+    jobs[ticket].state = JOB_QUEUED;
+    jobs[ticket].start = start;
+    jobs[ticket].goal  = goal;
+    queue.push_back(ticket);
+
+    has_work.notify_one();
+    return ticket;
+}
+
+PathService::PathStatus PathService::collect(int ticket, std::vector<TilePosition> *path)
+{
+    std::lock_guard<std::mutex> lock(queue_lock);
+
+    Job &job = jobs[ticket];
+    if (job.state != JOB_DONE) return PATH_PENDING;
+
+    path->swap(job.path);
+    job.path.clear();
+    job.state = JOB_FREE;
+    free_jobs.push_back(ticket);
+    return job.is_found ? PATH_FOUND : PATH_NOT_FOUND;
+}
+
+void PathService::cancel(int ticket)
+{
+    std::lock_guard<std::mutex> lock(queue_lock);
+
+    Job &job = jobs[ticket];
+    switch (job.state)
+    {
+        // A worker has it; it frees it when it's done
+        case JOB_WORKING:
+            job.state = JOB_CANCELLED;
+            return;
+
+        case JOB_QUEUED:
+            queue.erase(std::find(queue.begin(), queue.end(), ticket));
+            break;
+
+        case JOB_DONE:
+            job.path.clear();
+            break;
+
+        default:
+            return;
+    }
+    job.state = JOB_FREE;
+    free_jobs.push_back(ticket);
+}
+
+/**
+ CHANGES
+ */
+void PathService::set_tile(int x, int y, unsigned int tile)
+{
+    std::unique_lock<std::shared_mutex> lock(graph_lock);
+
+    map->set_tile(x, y, tile);
+    graph.mark_changed(x, y);
+    graph.repair();
+}
+
+/**
+ SERVING
+ */
+bool PathService::take_job(int *ticket, TilePosition *start, TilePosition *goal)
+{
+    if (queue.empty()) return false;
+
+    *ticket = queue.front();
+    queue.pop_front();
+
+    Job &job = jobs[*ticket];
+    job.state = JOB_WORKING;
+    *start = job.start;
+    *goal  = job.goal;
+    return true;
+}
+
+void PathService::finish_job(int ticket, bool is_found, std::vector<TilePosition> *found_path)
+{
+    std::lock_guard<std::mutex> lock(queue_lock);
+
+    Job &job = jobs[ticket];
+    if (job.state == JOB_CANCELLED)
+    {
+        job.state = JOB_FREE;
+        free_jobs.push_back(ticket);
+        return;
+    }
+
+    // Swapped rather than copied: whoever found it gets the job's old vector to fill next time
+    job.path.swap(*found_path);
+    job.is_found = is_found;
+    job.state = JOB_DONE;
+}
+
+bool PathService::search_for(TilePosition start, TilePosition goal, ClusterGraph::Search *search, std::vector<TilePosition> *found_path)
+{
+    std::shared_lock<std::shared_mutex> lock(graph_lock);
+    return graph.find_path(start, goal, search, found_path, max_expansions);
+}
+
+void PathService::work()
+{
+    AllocationTracker::ignore_this_thread();
+
+    ClusterGraph::Search search;
+    std::vector<TilePosition> found_path;
+
+    while (true)
+    {
+        int ticket;
+        TilePosition start, goal;
+        {
+            std::unique_lock<std::mutex> lock(queue_lock);
+            has_work.wait(lock, [this] { return is_stopping || !queue.empty(); });
+            if (is_stopping) return;
+
+            take_job(&ticket, &start, &goal);
+        }
+
+        bool is_found = search_for(start, goal, &search, &found_path);
+        finish_job(ticket, is_found, &found_path);
+    }
+}
+
+void PathService::update(float budget_ms)
+{
+    if (!workers.empty()) return;
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    std::chrono::duration<float, std::milli> budget(budget_ms);
+
+    // Always at least one, so a tiny budget still gets through the queue eventually
+    do {
+        int ticket;
+        TilePosition start, goal;
+        {
+            std::lock_guard<std::mutex> lock(queue_lock);
+            if (!take_job(&ticket, &start, &goal)) return;
+        }
+
+        bool is_found = search_for(start, goal, &search, &path);
+        finish_job(ticket, is_found, &path);
+    } while (std::chrono::steady_clock::now() - start_time < budget);
+}
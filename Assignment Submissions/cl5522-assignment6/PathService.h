@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include "Map.h"
+#include "ClusterGraph.h"
+
+/**
+ * Answers path requests over a Map in the background.
+ *
+ * request() queues a search and hands back a ticket; collect() with that
+ * ticket gives PATH_PENDING until a worker thread has been through it, then
+ * the path, once. Agents ask when they need a new path and keep walking the
+ * old one (or standing still) until it arrives, so a frame never waits on a
+ * search.
+ *
+ * Searches run over a ClusterGraph of the map, each one stopped after
+ * max_expansions graph nodes so one hopeless request can't hold a worker
+ * for long. Tiles are only ever changed through set_tile(), which waits for
+ * the searches in flight, repairs the graph and lets them carry on.
+ *
+ * With no workers (e.g. a single core), nothing runs until update() serves
+ * the queue on the calling thread, for as long as its budget allows.
+ */
+class PathService {
+public:
+    static const int DEFAULT_MAX_EXPANSIONS = 4096;
+    static const int NO_TICKET = -1;
+
+    enum PathStatus { PATH_PENDING, PATH_FOUND, PATH_NOT_FOUND };
+
+    PathService(Map *map, int worker_count, int max_expansions = DEFAULT_MAX_EXPANSIONS);
+    ~PathService();
+
+    int request(TilePosition start, TilePosition goal);
+
+    // Once this says FOUND or NOT_FOUND the ticket is spent. The path is swapped into
+    // `path`, so passing the same vector each time reuses its memory
+    PathStatus collect(int ticket, std::vector<TilePosition> *path);
+
+    // For a ticket whose path is no longer wanted
+    void cancel(int ticket);
+
+    void set_tile(int x, int y, unsigned int tile);
+
+    // Serves queued requests on this thread for up to budget_ms; only needed without workers
+    void update(float budget_ms);
+
+    const ClusterGraph &get_graph() const { return graph; };
+    int const get_worker_count() const { return (int) workers.size(); };
+
+private:
+    enum JobState { JOB_FREE, JOB_QUEUED, JOB_WORKING, JOB_CANCELLED, JOB_DONE };
+
+    struct Job
+    {
+        JobState state;
+        TilePosition start, goal;
+        bool is_found;
+        std::vector<TilePosition> path;
+    };
+
+    Map *map;
+    ClusterGraph graph;
+    int max_expansions;
+
+    // Searches share the graph; set_tile() has it to itself
+    std::shared_mutex graph_lock;
+
+    // Guards everything below
+    std::mutex queue_lock;
+    std::condition_variable has_work;
+    std::vector<Job> jobs; // the ticket is the index
+    std::vector<int> free_jobs;
+    std::deque<int> queue;
+    bool is_stopping;
+
+    std::vector<std::thread> workers;
+
+    // For update()
+    ClusterGraph::Search search;
+    std::vector<TilePosition> path;
+
+    void work();
+    bool take_job(int *ticket, TilePosition *start, TilePosition *goal);
+    void finish_job(int ticket, bool is_found, std::vector<TilePosition> *found_path);
+    bool search_for(TilePosition start, TilePosition goal, ClusterGraph::Search *search, std::vector<TilePosition> *found_path);
+};
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "PerfStats.h"
+#include "Utility.h"
+
+#define OVERLAY_TEXT_SIZE 0.15f
+#define OVERLAY_TEXT_SPACING 0.02f
+#define OVERLAY_LINE_HEIGHT 0.25f
+
+PerfStats::Counters PerfStats::frame_counters = { 0, 0, 0, 0, 0, 0 };
+PerfStats::Counters PerfStats::last_counters  = { 0, 0, 0, 0, 0, 0 };
+RenderStats PerfStats::last_render = { 0, 0, 0, 0, 0, 0, 0 };
+FramePacer::Stats PerfStats::last_pacing = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+Uint64 PerfStats::frame_start = 0;
+float PerfStats::frame_times[PerfStats::FRAME_HISTORY];
+int PerfStats::frame_time_count = 0;
+int PerfStats::next_frame_time  = 0;
+
+void PerfStats::begin_frame()
+{
+    memset(&frame_counters, 0, sizeof(frame_counters));
+    frame_start = SDL_GetPerformanceCounter();
+}
+
+void PerfStats::end_frame(const RenderStats &render, const FramePacer::Stats &pacing)
+{
+    float frame_time = (float) (SDL_GetPerformanceCounter() - frame_start) * 1000.0f / (float) SDL_GetPerformanceFrequency();
+
+    frame_times[next_frame_time] = frame_time;
+    next_frame_time = (next_frame_time + 1) % FRAME_HISTORY;
+    if (frame_time_count < FRAME_HISTORY) frame_time_count++;
+
+    last_counters = frame_counters;
+    last_render   = render;
+    last_pacing   = pacing;
+}
+
+float const PerfStats::get_frame_time_min()
+{
+    if (frame_time_count == 0) return 0.0f;
+    return *std::min_element(frame_times, frame_times + frame_time_count);
+}
+
+float const PerfStats::get_frame_time_avg()
+{
+    if (frame_time_count == 0) return 0.0f;
+
+    float total = 0.0f;
+    for (int i = 0; i < frame_time_count; i++) total += frame_times[i];
+    return total / frame_time_count;
+}
+
+float const PerfStats::get_frame_time_p99()
+{
+    if (frame_time_count == 0) return 0.0f;
+
+    // Partially sort a copy so the history keeps its order
+    float sorted[FRAME_HISTORY];
+    memcpy(sorted, frame_times, frame_time_count * sizeof(float));
+
+    int index = frame_time_count * 99 / 100;
+    std::nth_element(sorted, sorted + index, sorted + frame_time_count);
+    return sorted[index];
+}
+
+void PerfStats::draw_overlay(ShaderProgram *program, RenderQueue *queue, GLuint font_texture_id, glm::vec3 top_left)
+{
+    // The text arrays come out of the frame arena, so these only need to live until each call returns
+    char line[64];
+    glm::vec3 position = top_left;
+
+    snprintf(line, sizeof(line), "ms %.1f min %.1f avg %.1f p99",
+             get_frame_time_min(), get_frame_time_avg(), get_frame_time_p99());
+    Utility::draw_text(program, queue, font_texture_id, line, OVERLAY_TEXT_SIZE, OVERLAY_TEXT_SPACING, position);
+    position.y -= OVERLAY_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "pace %.1f of %.1f jitter %.2f max %.2f",
+             last_pacing.interval_avg_ms, last_pacing.target_ms, last_pacing.jitter_avg_ms, last_pacing.jitter_max_ms);
+    Utility::draw_text(program, queue, font_texture_id, line, OVERLAY_TEXT_SIZE, OVERLAY_TEXT_SPACING, position);
+    position.y -= OVERLAY_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "draws %d verts %d kb %.1f",
+             last_render.draw_calls, last_render.vertices, last_render.bytes_uploaded / 1024.0f);
+    Utility::draw_text(program, queue, font_texture_id, line, OVERLAY_TEXT_SIZE, OVERLAY_TEXT_SPACING, position);
+    position.y -= OVERLAY_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "programs %d textures %d uniforms %d",
+             last_render.program_binds, last_render.texture_binds, last_render.uniform_uploads);
+    Utility::draw_text(program, queue, font_texture_id, line, OVERLAY_TEXT_SIZE, OVERLAY_TEXT_SPACING, position);
+    position.y -= OVERLAY_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "updates %d pairs %d ai %d (%d late)",
+             last_counters.entities_updated, last_counters.collision_pairs_tested,
+             last_counters.ai_ticks, last_counters.ai_deferred);
+    Utility::draw_text(program, queue, font_texture_id, line, OVERLAY_TEXT_SIZE, OVERLAY_TEXT_SPACING, position);
+    position.y -= OVERLAY_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "sight rays %d cached %d",
+             last_counters.sight_rays, last_counters.sight_cached);
+    Utility::draw_text(program, queue, font_texture_id, line, OVERLAY_TEXT_SIZE, OVERLAY_TEXT_SPACING, position);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+#include "RenderQueue.h"
+#include "RenderDevice.h"
+#include "FramePacer.h"
+
+/**
+ * Per-frame counters for tuning: what the simulation did (counted by Entity
+ * as it goes), what the render device was asked to do, how long the frame's
+ * work took and how evenly the FramePacer is spacing frames out. Frame
+ * times are kept for the last FRAME_HISTORY frames so the overlay can show
+ * min/avg/p99 rather than one jumpy number.
+ *
+ * Like AllocationTracker, this never allocates.
+ */
+class PerfStats {
+public:
+    static const int FRAME_HISTORY = 240;
+
+    struct Counters
+    {
+        int entities_updated;
+        int collision_pairs_tested;
+        int ai_ticks;
+        int ai_deferred; // due, but over the AI budget
+        int sight_rays;
+        int sight_cached; // answered from another enemy's ray on the same tile
+    };
+
+    static void begin_frame();
+    static void end_frame(const RenderStats &render, const FramePacer::Stats &pacing);
+
+    static void count_update()          { frame_counters.entities_updated++; };
+    static void count_pairs(int pairs)  { frame_counters.collision_pairs_tested += pairs; };
+    static void count_ai(int ticks, int deferred) { frame_counters.ai_ticks += ticks; frame_counters.ai_deferred += deferred; };
+    static void count_sight(bool is_cached) { if (is_cached) frame_counters.sight_cached++; else frame_counters.sight_rays++; };
+
+    // For the last finished frame
+    static Counters    const get_frame()  { return last_counters; };
+    static RenderStats const get_render() { return last_render; };
+    static FramePacer::Stats const get_pacing() { return last_pacing; };
+
+    // In milliseconds, over the frames in the history
+    static float const get_frame_time_min();
+    static float const get_frame_time_avg();
+    static float const get_frame_time_p99();
+
+    // Queues the numbers above as text, top_left being the world position of the first line
+    static void draw_overlay(ShaderProgram *program, RenderQueue *queue, GLuint font_texture_id, glm::vec3 top_left);
+
+private:
+    static Counters frame_counters;
+    static Counters last_counters;
+    static RenderStats last_render;
+    static FramePacer::Stats last_pacing;
+
+    static Uint64 frame_start;
+    static float frame_times[FRAME_HISTORY];
+    static int frame_time_count;
+    static int next_frame_time;
+};
@@ -0,0 +1,98 @@
+#include <string.h>
+#include "RenderDevice.h"
+
+RenderDevice::RenderDevice()
+{
+    memset(&stats, 0, sizeof(stats));
+    memset(array_components, 0, sizeof(array_components));
+}
+
+void RenderDevice::begin_frame()
+{
+    memset(&stats, 0, sizeof(stats));
+    apply_clear();
+}
+
+void RenderDevice::set_program(ShaderProgram *program)
+{
+    stats.state_changes++;
+    stats.program_binds++;
+    apply_program(program);
+}
+
+void RenderDevice::set_texture(GLuint texture_id)
+{
+    stats.state_changes++;
+    stats.texture_binds++;
+    apply_texture(texture_id);
+}
+
+void RenderDevice::set_sprite_sheet(int cols, int rows)
+{
+    stats.state_changes++;
+    stats.uniform_uploads++;
+    stats.bytes_uploaded += 2 * sizeof(float);
+    apply_sprite_sheet(cols, rows);
+}
+
+void RenderDevice::set_sprite_index(int index)
+{
+    stats.state_changes++;
+    stats.uniform_uploads++;
+    stats.bytes_uploaded += sizeof(float);
+    apply_sprite_index(index);
+}
+
+void RenderDevice::set_model_matrix(const glm::mat4 &matrix)
+{
+    stats.state_changes++;
+    stats.uniform_uploads++;
+    stats.bytes_uploaded += sizeof(glm::mat4);
+    apply_model_matrix(matrix);
+}
+
+void RenderDevice::set_vertex_array(VertexAttribute attribute, const float *data, int components)
+{
+    stats.state_changes++;
+    array_components[attribute] = data == NULL ? 0 : components;
+    apply_vertex_array(attribute, data, components);
+}
+
+void RenderDevice::draw(int vertex_count)
+{
+    stats.draw_calls++;
+    stats.vertices += vertex_count;
+
+    // Client-side arrays are read (and sent over) again on every draw
+    for (int attribute = 0; attribute < VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        stats.bytes_uploaded += (size_t) vertex_count * array_components[attribute] * sizeof(float);
+    }
+
+    apply_draw(vertex_count);
+}
+
+void RenderDevice::present()
+{
+    apply_present();
+}
+
+GLuint RenderDevice::create_texture(int width, int height, const unsigned char *pixels)
+{
+    return apply_create_texture(width, height, pixels);
+}
+
+void RenderDevice::load_program(ShaderProgram *program, const char *vertex_shader_file, const char *fragment_shader_file)
+{
+    apply_load_program(program, vertex_shader_file, fragment_shader_file);
+}
+
+void RenderDevice::set_view_matrix(ShaderProgram *program, const glm::mat4 &matrix)
+{
+    apply_view_matrix(program, matrix);
+}
+
+void RenderDevice::set_projection_matrix(ShaderProgram *program, const glm::mat4 &matrix)
+{
+    apply_projection_matrix(program, matrix);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <stddef.h>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+
+enum VertexAttribute { VERTEX_POSITION, VERTEX_TEXTURE_COORDINATE, VERTEX_SPRITE_INDEX, VERTEX_ATTRIBUTE_COUNT };
+
+// What one frame asked of the device
+struct RenderStats
+{
+    int draw_calls;
+    int vertices;
+    int state_changes;   // program, texture, uniform and vertex array changes
+    int program_binds;
+    int texture_binds;
+    int uniform_uploads;
+    size_t bytes_uploaded; // vertex data read by draws plus uniform data
+};
+
+/**
+ * Everything the render queue needs from the graphics API, so it can draw
+ * through OpenGL (GLRenderDevice) or through nothing at all
+ * (NullRenderDevice) when there is no context, e.g. to measure a scene.
+ *
+ * The public calls count what they are asked to do and pass it on to the
+ * backend's apply_*(), so both backends report the same numbers.
+ */
+class RenderDevice {
+private:
+    RenderStats stats;
+    int array_components[VERTEX_ATTRIBUTE_COUNT]; // 0 while an array is off
+
+protected:
+    virtual void apply_clear() = 0;
+    virtual void apply_program(ShaderProgram *program) = 0;
+    virtual void apply_texture(GLuint texture_id) = 0;
+    virtual void apply_sprite_sheet(int cols, int rows) = 0;
+    virtual void apply_sprite_index(int index) = 0;
+    virtual void apply_model_matrix(const glm::mat4 &matrix) = 0;
+    virtual void apply_vertex_array(VertexAttribute attribute, const float *data, int components) = 0;
+    virtual void apply_draw(int vertex_count) = 0;
+
+    virtual GLuint apply_create_texture(int width, int height, const unsigned char *pixels) = 0;
+    virtual void apply_load_program(ShaderProgram *program, const char *vertex_shader_file, const char *fragment_shader_file) = 0;
+    virtual void apply_view_matrix(ShaderProgram *program, const glm::mat4 &matrix) = 0;
+    virtual void apply_projection_matrix(ShaderProgram *program, const glm::mat4 &matrix) = 0;
+    virtual void apply_present() = 0;
+
+public:
+    RenderDevice();
+    virtual ~RenderDevice() {};
+
+    // Clears the screen and starts counting from zero
+    void begin_frame();
+
+    void set_program(ShaderProgram *program);
+    void set_texture(GLuint texture_id);
+    void set_sprite_sheet(int cols, int rows);
+    void set_sprite_index(int index);
+    void set_model_matrix(const glm::mat4 &matrix);
+
+    // data == NULL switches the array off
+    void set_vertex_array(VertexAttribute attribute, const float *data, int components);
+    void draw(int vertex_count);
+
+    // Shows the frame just drawn
+    void present();
+
+    // Setting up, outside of any frame, so none of it is counted
+    GLuint create_texture(int width, int height, const unsigned char *pixels); // RGBA, 8 bits each
+    void load_program(ShaderProgram *program, const char *vertex_shader_file, const char *fragment_shader_file);
+    void set_view_matrix(ShaderProgram *program, const glm::mat4 &matrix);
+    void set_projection_matrix(ShaderProgram *program, const glm::mat4 &matrix);
+
+    RenderStats const get_stats() const { return stats; };
+};
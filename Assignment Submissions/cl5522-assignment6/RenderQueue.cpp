@@ -0,0 +1,186 @@
+#include <string.h>
+#include "RenderQueue.h"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+const float RenderQueue::QUAD_VERTICES[12] =
+{
+    -0.5, -0.5, 0.5, -0.5,  0.5, 0.5,
+    -0.5, -0.5, 0.5,  0.5, -0.5, 0.5
+};
+
+const float RenderQueue::QUAD_TEXTURE_COORDINATES[12] =
+{
+    0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+    0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f
+};
+
+RenderQueue::RenderQueue(int capacity)
+{
+    commands.reserve(capacity);
+    keys.reserve(capacity);
+    sorted_keys.reserve(capacity);
+    scratch_keys.reserve(capacity);
+    sorted_order.reserve(capacity);
+    scratch_order.reserve(capacity);
+}
+
+uint64_t RenderQueue::make_key(RenderLayer layer, unsigned int shader, GLuint texture_id, unsigned int depth)
+{
+    return ((uint64_t) (layer      & 0xFF)     << 56) |
+           ((uint64_t) (shader     & 0xFF)     << 48) |
+           ((uint64_t) (texture_id & 0xFFFFFF) << 24) |
+            (uint64_t) (depth      & 0xFFFFFF);
+}
+
+RenderCommand *RenderQueue::add(ShaderProgram *program, RenderLayer layer, GLuint texture_id, unsigned int depth)
+{
+    RenderCommand command;
+    command.program             = program;
+    command.texture_id          = texture_id;
+    command.model_matrix        = glm::mat4(1.0f);
+    command.vertices            = QUAD_VERTICES;
+    command.texture_coordinates = QUAD_TEXTURE_COORDINATES;
+    command.vertex_count        = 6;
+    command.sprite_cols         = 1;
+    command.sprite_rows         = 1;
+    command.sprite_index        = 0;
+    command.sprite_indices      = NULL;
+
+    commands.push_back(command);
+    keys.push_back(make_key(layer, program->programID, texture_id, depth));
+
+    return &commands.back();
+}
+
+/**
+ * LSD radix sort, one byte per pass. A pass whose byte is the same for every
+ * key wouldn't move anything, so it is skipped; with only a handful of
+ * layers and textures most of the eight passes are.
+ */
+void RenderQueue::sort()
+{
+    int count = (int) keys.size();
+
+    sorted_keys.assign(keys.begin(), keys.end());
+    sorted_order.resize(count);
+    scratch_keys.resize(count);
+    scratch_order.resize(count);
+    for (int i = 0; i < count; i++) sorted_order[i] = i;
+
+    for (int shift = 0; shift < 64; shift += RADIX_BITS)
+    {
+        // Step 1: Count how many keys land in each bucket
+        int offsets[RADIX_BUCKETS];
+        memset(offsets, 0, sizeof(offsets));
+        for (int i = 0; i < count; i++) offsets[(sorted_keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+
+        if (count == 0 || offsets[(sorted_keys[0] >> shift) & (RADIX_BUCKETS - 1)] == count) continue;
+
+        // Step 2: Turn the counts into where each bucket starts
+        int total = 0;
+        for (int bucket = 0; bucket < RADIX_BUCKETS; bucket++)
+        {
+            int bucket_count = offsets[bucket];
+            offsets[bucket] = total;
+            total += bucket_count;
+        }
+
+        // Step 3: Scatter, keeping keys in the same bucket in order
+        for (int i = 0; i < count; i++)
+        {
+            int destination = offsets[(sorted_keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+            scratch_keys[destination]  = sorted_keys[i];
+            scratch_order[destination] = sorted_order[i];
+        }
+
+        sorted_keys.swap(scratch_keys);
+        sorted_order.swap(scratch_order);
+    }
+}
+
+void RenderQueue::submit(RenderDevice *device)
+{
+    sort();
+
+    // What is currently bound, so we only change what differs
+    ShaderProgram *program = NULL;
+    GLuint texture_id = 0;
+    bool has_texture = false;
+    int sprite_cols = 0, sprite_rows = 0;
+    const float *vertices = NULL, *texture_coordinates = NULL;
+    bool has_sprite_index_array = false;
+
+    for (int i = 0; i < (int) sorted_order.size(); i++)
+    {
+        const RenderCommand &command = commands[sorted_order[i]];
+
+        // Step 1: A new program means nothing that was bound still applies
+        if (command.program != program)
+        {
+            program = command.program;
+            device->set_program(program);
+
+            sprite_cols = sprite_rows = 0;
+            vertices = texture_coordinates = NULL;
+            has_sprite_index_array = false;
+        }
+
+        // Step 2: Bind whatever changed
+        if (!has_texture || command.texture_id != texture_id)
+        {
+            device->set_texture(command.texture_id);
+            texture_id  = command.texture_id;
+            has_texture = true;
+        }
+
+        if (command.sprite_cols != sprite_cols || command.sprite_rows != sprite_rows)
+        {
+            device->set_sprite_sheet(command.sprite_cols, command.sprite_rows);
+            sprite_cols = command.sprite_cols;
+            sprite_rows = command.sprite_rows;
+        }
+
+        if (command.vertices != vertices)
+        {
+            device->set_vertex_array(VERTEX_POSITION, command.vertices, 2);
+            vertices = command.vertices;
+        }
+
+        if (command.texture_coordinates != texture_coordinates)
+        {
+            device->set_vertex_array(VERTEX_TEXTURE_COORDINATE, command.texture_coordinates, 2);
+            texture_coordinates = command.texture_coordinates;
+        }
+
+        if (command.sprite_indices != NULL)
+        {
+            device->set_vertex_array(VERTEX_SPRITE_INDEX, command.sprite_indices, 1);
+            has_sprite_index_array = true;
+        }
+        else
+        {
+            if (has_sprite_index_array) device->set_vertex_array(VERTEX_SPRITE_INDEX, NULL, 1);
+            device->set_sprite_index(command.sprite_index);
+            has_sprite_index_array = false;
+        }
+
+        // Step 3: Draw
+        device->set_model_matrix(command.model_matrix);
+        device->draw(command.vertex_count);
+    }
+
+    // Leave no arrays pointing into memory we don't own
+    if (vertices != NULL)               device->set_vertex_array(VERTEX_POSITION, NULL, 2);
+    if (texture_coordinates != NULL)    device->set_vertex_array(VERTEX_TEXTURE_COORDINATE, NULL, 2);
+    if (has_sprite_index_array)         device->set_vertex_array(VERTEX_SPRITE_INDEX, NULL, 1);
+
+    clear();
+}
+
+void RenderQueue::clear()
+{
+    commands.clear();
+    keys.clear();
+}
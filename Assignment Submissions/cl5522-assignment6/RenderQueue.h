@@ -0,0 +1,77 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <stdint.h>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+#include "RenderDevice.h"
+
+// Back to front
+enum RenderLayer { RENDER_LAYER_MAP, RENDER_LAYER_WORLD, RENDER_LAYER_EFFECTS, RENDER_LAYER_PLAYER, RENDER_LAYER_UI };
+
+/**
+ * One draw call worth of triangles. add() fills it in as a unit quad
+ * showing the whole texture; callers change whatever they need.
+ */
+struct RenderCommand
+{
+    ShaderProgram *program;
+    GLuint texture_id;
+    glm::mat4 model_matrix;
+
+    const float *vertices;             // two floats per vertex
+    const float *texture_coordinates;  // two floats per vertex
+    int vertex_count;
+
+    int sprite_cols;
+    int sprite_rows;
+    int sprite_index;
+    const float *sprite_indices;       // one per vertex, or NULL to use sprite_index for all
+};
+
+/**
+ * Collects a frame's draw commands so they can be drawn in a sensible order
+ * instead of the order the scene happens to list them in.
+ *
+ * Every command gets a 64-bit key:
+ *
+ *     [layer: 8 bits][shader: 8 bits][texture: 24 bits][depth: 24 bits]
+ *
+ * submit() radix sorts the keys (back to front by layer, then grouped by
+ * shader and texture) and only sends the device state that differs from
+ * the previous command's. The sort is stable, so commands with equal keys are
+ * drawn in the order they were added.
+ */
+class RenderQueue {
+private:
+    std::vector<RenderCommand> commands;
+    std::vector<uint64_t> keys;
+
+    // Radix sort work space: (key, command) pairs, ping-ponged between passes
+    std::vector<uint64_t> sorted_keys, scratch_keys;
+    std::vector<int> sorted_order, scratch_order;
+
+    void sort();
+
+public:
+    static const float QUAD_VERTICES[12];
+    static const float QUAD_TEXTURE_COORDINATES[12];
+
+    RenderQueue(int capacity);
+
+    static uint64_t make_key(RenderLayer layer, unsigned int shader, GLuint texture_id, unsigned int depth);
+
+    RenderCommand *add(ShaderProgram *program, RenderLayer layer, GLuint texture_id, unsigned int depth = 0);
+    void submit(RenderDevice *device);
+    void clear();
+
+    int const get_count() const { return (int) commands.size(); };
+};
@@ -0,0 +1,232 @@
+#include <string.h>
+#include "RewindBuffer.h"
+
+#define MIN_GAP 3 // unchanged bytes needed to end a run of changed ones; fewer are cheaper to carry than a new run
+
+// Runs after the first skip at least MIN_GAP bytes for their two counts, so a
+// delta never comes to twice what it covers, see encode()
+#define ENCODED_BOUND(size) (2 * (size) + 16)
+
+// Counts take seven bits a byte, the top bit set on every byte but the last,
+// so a run of under 128 costs one byte
+static size_t write_count(unsigned char *out, size_t count)
+{
+    size_t length = 0;
+    while (count >= 0x80)
+    {
+        out[length++] = (unsigned char) (count | 0x80);
+        count >>= 7;
+    }
+    out[length++] = (unsigned char) count;
+    return length;
+}
+
+static const unsigned char *read_count(const unsigned char *in, size_t *count)
+{
+    *count = 0;
+    for (int shift = 0; ; shift += 7)
+    {
+        *count |= (size_t) (*in & 0x7F) << shift;
+        if (!(*in++ & 0x80)) return in;
+    }
+}
+
+// A step where nothing changed stores nothing, but still takes a byte of the
+// ring so every frame has a place of its own to be found at
+static size_t extent(size_t encoded_size)
+{
+    return encoded_size > 0 ? encoded_size : 1;
+}
+
+RewindBuffer::RewindBuffer(int frame_capacity, size_t storage_size, size_t max_snapshot_size)
+{
+    this->frame_capacity    = frame_capacity;
+    this->storage_size      = storage_size;
+    this->max_snapshot_size = max_snapshot_size;
+
+    storage = new unsigned char[storage_size];
+    frames  = new Frame[frame_capacity];
+    latest  = new unsigned char[max_snapshot_size](); // zeroed, see latest
+    encoded = new unsigned char[ENCODED_BOUND(max_snapshot_size)];
+}
+
+void RewindBuffer::reserve(size_t max_snapshot_size)
+{
+    if (max_snapshot_size <= this->max_snapshot_size) return;
+
+    delete [] latest;
+    delete [] encoded;
+
+    this->max_snapshot_size = max_snapshot_size;
+    latest  = new unsigned char[max_snapshot_size](); // zeroed, see latest
+    encoded = new unsigned char[ENCODED_BOUND(max_snapshot_size)];
+
+    // The frame every delta leads back from is gone
+    clear();
+}
+
+RewindBuffer::~RewindBuffer()
+{
+    delete [] storage;
+    delete [] frames;
+    delete [] latest;
+    delete [] encoded;
+}
+
+/**
+ * XORs raw against latest (both read as zeros past their ends) and run-length
+ * encodes the result into `encoded` as a series of
+ *
+ *     [unchanged byte count][changed byte count][changed bytes, XORed]
+ *
+ * Changed runs only stop at MIN_GAP unchanged bytes, so every run after the
+ * first skips at least as many bytes as its counts usually cost.
+ */
+size_t RewindBuffer::encode(const unsigned char *raw, size_t raw_size)
+{
+    size_t size = raw_size > latest_size ? raw_size : latest_size;
+    size_t in = 0, out = 0;
+
+    while (in < size)
+    {
+        // Step 1: Skip what hasn't changed
+        size_t unchanged = 0;
+        while (in + unchanged < size &&
+               (in + unchanged < raw_size ? raw[in + unchanged] : 0) == latest[in + unchanged]) unchanged++;
+        in += unchanged;
+        if (in == size) break; // nothing left to record
+
+        // Step 2: Take what has, up to the next gap
+        size_t changed = 0, gap = 0;
+        while (in + changed < size && gap < MIN_GAP)
+        {
+            bool same = (in + changed < raw_size ? raw[in + changed] : 0) == latest[in + changed];
+            gap = same ? gap + 1 : 0;
+            changed++;
+        }
+        changed -= gap; // leave the trailing unchanged bytes for the next run
+
+        out += write_count(encoded + out, unchanged);
+        out += write_count(encoded + out, changed);
+
+        for (size_t i = 0; i < changed; i++, in++)
+        {
+            encoded[out++] = (in < raw_size ? raw[in] : 0) ^ latest[in];
+        }
+    }
+
+    return out;
+}
+
+// XORs a stored frame into latest, which turns it into the frame before
+void RewindBuffer::decode(const Frame &frame)
+{
+    const unsigned char *in  = storage + frame.offset;
+    const unsigned char *end = in + frame.encoded_size;
+    size_t position = 0;
+
+    while (in < end)
+    {
+        size_t unchanged, changed;
+        in = read_count(in, &unchanged);
+        in = read_count(in, &changed);
+
+        position += unchanged;
+        for (size_t i = 0; i < changed; i++) latest[position++] ^= *in++;
+    }
+}
+
+void RewindBuffer::drop_oldest()
+{
+    // The frame after it still leads back to it, but nothing will follow that there
+    oldest = (oldest + 1) % frame_capacity;
+    count--;
+}
+
+bool RewindBuffer::overlaps_oldest(size_t offset, size_t size)
+{
+    Frame &frame = frame_at(0);
+    return offset < frame.offset + extent(frame.encoded_size) && frame.offset < offset + size;
+}
+
+size_t RewindBuffer::make_room(size_t size)
+{
+    size_t offset = write_offset;
+
+    if (offset + size > storage_size)
+    {
+        // Wrapping around: whatever sits between here and the end is older than what's at the start
+        while (count > 0 && frame_at(0).offset >= write_offset) drop_oldest();
+        offset = 0;
+    }
+
+    while (count > 0 && (count == frame_capacity || overlaps_oldest(offset, size))) drop_oldest();
+
+    return offset;
+}
+
+bool RewindBuffer::push(const Snapshot &snapshot)
+{
+    const unsigned char *raw = snapshot.get_data();
+    size_t raw_size = snapshot.get_size();
+    if (raw_size > max_snapshot_size) return false;
+
+    // Step 1: Encode the way back to the newest frame. The first one has nowhere to go back to
+    size_t size = count > 0 ? encode(raw, raw_size) : 0;
+    if (extent(size) > storage_size) return false;
+
+    // Step 2: Clear space for it and store it
+    size_t offset = make_room(extent(size));
+    memcpy(storage + offset, encoded, size);
+    write_offset = offset + extent(size);
+
+    Frame &frame = frames[(oldest + count) % frame_capacity];
+    frame.offset        = offset;
+    frame.encoded_size  = size;
+    frame.previous_size = latest_size;
+    count++;
+
+    // Step 3: It's the newest frame now, kept zero past its end
+    memcpy(latest, raw, raw_size);
+    if (latest_size > raw_size) memset(latest + raw_size, 0, latest_size - raw_size);
+    latest_size = raw_size;
+
+    return true;
+}
+
+bool RewindBuffer::pop(Snapshot *snapshot)
+{
+    if (count == 0) return false;
+
+    // Step 1: The newest frame is the one we keep whole
+    snapshot->load(latest, latest_size);
+
+    // Step 2: Step latest back to the frame before. Its delta comes out to
+    //         zeros past the end of that frame, so latest stays clean
+    Frame &frame = frame_at(count - 1);
+    if (count > 1) decode(frame);
+    else memset(latest, 0, latest_size);
+    latest_size = count > 1 ? frame.previous_size : 0;
+
+    // Step 3: Forget it. The space it used is free again
+    write_offset = frame.offset;
+    count--;
+
+    return true;
+}
+
+void RewindBuffer::clear()
+{
+    oldest = 0;
+    count  = 0;
+    write_offset = 0;
+    if (latest_size > 0) memset(latest, 0, latest_size);
+    latest_size = 0;
+}
+
+size_t const RewindBuffer::get_used_size()
+{
+    size_t used = 0;
+    for (int i = 0; i < count; i++) used += frame_at(i).encoded_size;
+    return used;
+}
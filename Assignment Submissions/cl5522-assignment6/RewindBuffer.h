@@ -0,0 +1,71 @@
+#pragma once
+#include "Snapshot.h"
+
+/**
+ * Keeps the last few seconds of snapshots so time can be run backwards.
+ *
+ * Only the newest snapshot is kept whole. Every frame stores the XOR between
+ * itself and the one before it, run-length encoded, and since XORing that
+ * into the newest snapshot gives back the one before, stepping back is one
+ * small decode. Nothing needs a keyframe, so a frame only costs the bytes
+ * that changed during its step: entities that stand still are free.
+ *
+ * All memory is allocated in the constructor and reserve(): encoded frames
+ * go into one fixed ring of bytes, and the oldest frames are dropped once it
+ * (or the frame table) is full. push() refuses a snapshot bigger than what
+ * was reserved, or one whose delta doesn't fit in the ring even on its own.
+ */
+class RewindBuffer {
+private:
+    struct Frame
+    {
+        size_t offset;
+        size_t encoded_size;
+        size_t previous_size; // raw size of the frame before, which the delta leads back to
+    };
+
+    // Encoded frames
+    unsigned char *storage;
+    size_t storage_size;
+    size_t write_offset = 0;
+
+    // Frame table, oldest first
+    Frame *frames;
+    int frame_capacity;
+    int oldest = 0;
+    int count  = 0;
+
+    // The newest frame, whole and zero past its end, which deltas are taken against
+    unsigned char *latest;
+    size_t latest_size = 0;
+
+    // Work space for encoding
+    size_t max_snapshot_size;
+    unsigned char *encoded;
+
+    Frame &frame_at(int i) { return frames[(oldest + i) % frame_capacity]; };
+
+    size_t encode(const unsigned char *raw, size_t raw_size);
+    void decode(const Frame &frame);
+    void drop_oldest();
+    bool overlaps_oldest(size_t offset, size_t size);
+    size_t make_room(size_t size);
+
+public:
+    RewindBuffer(int frame_capacity, size_t storage_size, size_t max_snapshot_size);
+    ~RewindBuffer();
+
+    // Makes room for snapshots up to max_snapshot_size bytes; growing forgets every frame
+    void reserve(size_t max_snapshot_size);
+
+    bool push(const Snapshot &snapshot);
+    bool pop(Snapshot *snapshot);
+    void clear();
+
+    // Bytes the stored deltas take up in the ring
+    size_t const get_used_size();
+
+    int    const get_count()        const { return count; };
+    size_t const get_storage_size() const { return storage_size; };
+    size_t const get_max_snapshot_size() const { return max_snapshot_size; };
+};
@@ -1 +1,153 @@
 #include "Scene.h"
+
+// FNV-1a, fed one value at a time
+static void hash_bytes(unsigned int *hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *) data;
+    for (size_t i = 0; i < size; i++)
+    {
+        *hash ^= bytes[i];
+        *hash *= 16777619u;
+    }
+}
+
+static void hash_entity(unsigned int *hash, const Entity *entity)
+{
+    glm::vec3 position = entity->get_position();
+    glm::vec3 velocity = entity->get_velocity();
+    float rotation     = entity->get_roatation();
+    int lives          = entity->get_lives();
+    bool is_active     = entity->get_active_state();
+    AIState ai_state   = entity->get_ai_state();
+
+    hash_bytes(hash, &position, sizeof(position));
+    hash_bytes(hash, &velocity, sizeof(velocity));
+    hash_bytes(hash, &rotation, sizeof(rotation));
+    hash_bytes(hash, &lives,    sizeof(lives));
+    hash_bytes(hash, &is_active, sizeof(is_active));
+    hash_bytes(hash, &ai_state, sizeof(ai_state));
+}
+
+/**
+ * Throws away everything initialise() made in one go. The scene can be
+ * initialised again afterwards.
+ */
+void Scene::release()
+{
+    state.player    = NULL;
+    state.enemies   = NULL;
+    state.map       = NULL;
+    state.particles = NULL;
+    state.bullet_vector.clear();
+    spare_bullets.clear();
+    number_of_enemies = 0;
+
+    arena.reset();
+}
+
+void Scene::reserve_bullets(int bullet_count)
+{
+    state.bullet_vector.reserve(bullet_count);
+    spare_bullets.reserve(bullet_count);
+    registry.reserve(1 + number_of_enemies + bullet_count);
+    update_batch.reserve(1 + number_of_enemies + bullet_count);
+}
+
+Entity *Scene::create_bullet()
+{
+    if (spare_bullets.empty()) return arena.create<Entity>();
+
+    // Rebuild a spent one in place so nothing from its last shot carries over
+    Entity *bullet = spare_bullets.back();
+    spare_bullets.pop_back();
+    bullet->~Entity();
+    new (bullet) Entity();
+    return bullet;
+}
+
+void Scene::add_bullet(Entity *bullet)
+{
+    state.bullet_vector.push_back(bullet);
+    registry.add(bullet);
+}
+
+void Scene::recycle_bullet(Entity *bullet)
+{
+    bullet->deactivate();
+    registry.remove(bullet->get_handle());
+    spare_bullets.push_back(bullet);
+}
+
+// Spent lasers are never coming back, so they go on the spare list
+void Scene::remove_inactive_bullets()
+{
+    for (int i = (int) state.bullet_vector.size() - 1; i >= 0; i--)
+    {
+        if (state.bullet_vector[i]->get_active_state()) continue;
+
+        recycle_bullet(state.bullet_vector[i]);
+        state.bullet_vector[i] = state.bullet_vector.back();
+        state.bullet_vector.pop_back();
+    }
+}
+
+/**
+ * Boils everything the simulation depends on down to one number, so two runs
+ * fed the same input can be compared step by step.
+ */
+unsigned int Scene::hash_state() const
+{
+    unsigned int hash = 2166136261u;
+
+    hash_bytes(&hash, &state.next_scene_id, sizeof(state.next_scene_id));
+
+    if (state.player != NULL) hash_entity(&hash, state.player);
+
+    for (int i = 0; i < number_of_enemies; i++) hash_entity(&hash, &state.enemies[i]);
+
+    for (const Entity *bullet : state.bullet_vector) hash_entity(&hash, bullet);
+
+    return hash;
+}
+
+void Scene::save_snapshot(Snapshot *snapshot) const
+{
+    int bullet_count = (int) state.bullet_vector.size();
+    snapshot->resize(number_of_enemies, bullet_count);
+    snapshot->get_header()->next_scene_id = state.next_scene_id;
+    snapshot->get_header()->ai_step = ai_scheduler.get_step();
+
+    EntitySnapshot *entities = snapshot->get_entities();
+    state.player->save(&entities[0]);
+    for (int i = 0; i < number_of_enemies; i++) state.enemies[i].save(&entities[1 + i]);
+    for (int i = 0; i < bullet_count; i++) state.bullet_vector[i]->save(&entities[1 + number_of_enemies + i]);
+}
+
+bool Scene::restore_snapshot(const Snapshot &snapshot)
+{
+    // A snapshot only fits the scene it was taken from
+    if (snapshot.is_empty() || snapshot.get_header()->enemy_count != number_of_enemies) return false;
+
+    const SnapshotHeader *header = snapshot.get_header();
+    const EntitySnapshot *entities = snapshot.get_entities();
+
+    state.next_scene_id = header->next_scene_id;
+    ai_scheduler.set_step(header->ai_step);
+    state.player->restore(entities[0]);
+    for (int i = 0; i < number_of_enemies; i++) state.enemies[i].restore(entities[1 + i]);
+
+    // Lasers come and go, so match the count before copying them back
+    while ((int) state.bullet_vector.size() > header->bullet_count)
+    {
+        recycle_bullet(state.bullet_vector.back());
+        state.bullet_vector.pop_back();
+    }
+    while ((int) state.bullet_vector.size() < header->bullet_count) add_bullet(create_bullet());
+
+    for (int i = 0; i < header->bullet_count; i++) state.bullet_vector[i]->restore(entities[1 + number_of_enemies + i]);
+
+    // Sparks from the future would look odd
+    if (state.particles != NULL) state.particles->clear();
+
+    return true;
+}
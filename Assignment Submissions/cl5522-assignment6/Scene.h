@@ -14,15 +14,25 @@
 #include "ShaderProgram.h"
 #include "Utility.h"
 #include "Entity.h"
+#include "EntityRegistry.h"
 #include "Map.h"
+#include "ParticleSystem.h"
+#include "Snapshot.h"
+#include "Arena.h"
+#include "AIScheduler.h"
+#include "VisibilityCache.h"
 #include <vector>
 
+#define SCENE_ARENA_SIZE (128 * 1024)
+#define SCENE_MAX_BULLETS 64 // most lasers in flight at once; a scene makes room for them all up front
+
 struct GameState
 {
-    Map *map;
-    Entity *player;
-    Entity *enemies;
+    Map *map        = NULL;
+    Entity *player  = NULL;
+    Entity *enemies = NULL;
     std::vector<Entity*> bullet_vector;
+    ParticleSystem *particles = NULL;
     
     Mix_Music *bgm;
     Mix_Chunk *jump_sfx;
@@ -31,15 +41,52 @@ struct GameState
 };
 
 class Scene {
+private:
+    // Spent lasers, kept to be rebuilt in place for the next shot
+    std::vector<Entity*> spare_bullets;
+    
+    void recycle_bullet(Entity *bullet);
+    
 public:
-    int number_of_enemies = 1;
+    int number_of_enemies = 0;
     
     GameState state;
-
+    EntityRegistry registry;
+    
+    // Work space for update_entities(), kept so stepping doesn't allocate
+    std::vector<Entity*> update_batch;
+    ContactList contacts;
+    AIScheduler ai_scheduler;
+    VisibilityCache visibility;
+    
+    // Everything initialise() makes. Declared after the registry so the
+    // entities in it are gone before the registry is
+    Arena arena{ SCENE_ARENA_SIZE };
     
     virtual void initialise() = 0;
     virtual void update(float delta_time) = 0;
-    virtual void render(ShaderProgram *program) = 0;
+    virtual void render(ShaderProgram *program, RenderQueue *queue, float alpha) = 0;
+    
+    // Nothing on screen changes unless the player does something, so the main
+    // loop can sleep until they do and skip drawing the same frame again
+    virtual bool const is_static() const { return false; };
+    
+    void release();
+    
+    // Sizes the laser lists, the registry and update_batch for bullet_count lasers on
+    // top of the player and enemies, so firing in steady state never allocates
+    void reserve_bullets(int bullet_count);
+    
+    // Firing does nothing while this is false, so lasers never outgrow what was reserved
+    bool const has_room_for_bullet() const { return state.bullet_vector.size() < SCENE_MAX_BULLETS; };
+    
+    Entity *create_bullet();
+    void add_bullet(Entity *bullet);
+    void remove_inactive_bullets();
+    
+    unsigned int hash_state() const;
+    void save_snapshot(Snapshot *snapshot) const;
+    bool restore_snapshot(const Snapshot &snapshot);
     
     GameState const get_state() const { return this->state; }
 };
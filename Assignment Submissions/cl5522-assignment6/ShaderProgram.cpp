@@ -25,11 +25,15 @@ void ShaderProgram::Load(const char *vertexShaderFile, const char *fragmentShade
     projectionMatrixUniform = glGetUniformLocation(programID, "projectionMatrix");
     viewMatrixUniform = glGetUniformLocation(programID, "viewMatrix");
 	colorUniform = glGetUniformLocation(programID, "color");
+    spriteSheetUniform = glGetUniformLocation(programID, "spriteSheet");
     
     positionAttribute = glGetAttribLocation(programID, "position");
     texCoordAttribute = glGetAttribLocation(programID, "texCoord");
+    spriteIndexAttribute = glGetAttribLocation(programID, "spriteIndex");
 	
 	SetColor(1.0f, 1.0f, 1.0f, 1.0f);
+    SetSpriteSheet(1, 1);
+    SetSpriteIndex(0);
     
 }
 
@@ -89,6 +93,16 @@ void ShaderProgram::SetColor(float r, float g, float b, float a) {
 	glUniform4f(colorUniform, r, g, b, a);
 }
 
+void ShaderProgram::SetSpriteSheet(int cols, int rows) {
+    glUseProgram(programID);
+    glUniform2f(spriteSheetUniform, (float) cols, (float) rows);
+}
+
+void ShaderProgram::SetSpriteIndex(int index) {
+    // Only the generic value is set here; draw_text feeds a per-vertex array instead
+    glVertexAttrib1f(spriteIndexAttribute, (float) index);
+}
+
 void ShaderProgram::SetViewMatrix(const glm::mat4 &matrix) {
     glUseProgram(programID);
     glUniformMatrix4fv(viewMatrixUniform, 1, GL_FALSE, &matrix[0][0]);
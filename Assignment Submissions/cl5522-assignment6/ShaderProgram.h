@@ -22,6 +22,8 @@ class ShaderProgram {
         void SetViewMatrix(const glm::mat4 &matrix);
 	
 		void SetColor(float r, float g, float b, float a);
+        void SetSpriteSheet(int cols, int rows);
+        void SetSpriteIndex(int index);
 	
         GLuint LoadShaderFromString(const std::string &shaderContents, GLenum type);
         GLuint LoadShaderFromFile(const std::string &shaderFile, GLenum type);
@@ -32,9 +34,11 @@ class ShaderProgram {
         GLuint modelMatrixUniform;
         GLuint viewMatrixUniform;
 		GLuint colorUniform;
+        GLuint spriteSheetUniform;
 	
         GLuint positionAttribute;
         GLuint texCoordAttribute;
+        GLuint spriteIndexAttribute;
     
         GLuint vertexShader;
         GLuint fragmentShader;
@@ -0,0 +1,22 @@
+#include <string.h>
+#include "Snapshot.h"
+
+void Snapshot::resize(int enemy_count, int bullet_count)
+{
+    // Player + enemies + bullets
+    data.resize(size_for(1 + enemy_count + bullet_count));
+
+    get_header()->enemy_count  = enemy_count;
+    get_header()->bullet_count = bullet_count;
+}
+
+void Snapshot::reserve(int entity_count)
+{
+    data.reserve(size_for(entity_count));
+}
+
+void Snapshot::load(const unsigned char *bytes, size_t size)
+{
+    data.resize(size);
+    memcpy(data.data(), bytes, size);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include "Entity.h"
+
+struct SnapshotHeader
+{
+    int next_scene_id;
+    int enemy_count;
+    int bullet_count;
+    int ammo;
+    int ai_step; // which enemies think on which step depends on it
+};
+
+/**
+ * A scene's whole simulation state as one flat, pointer-free block of bytes:
+ *
+ *     [SnapshotHeader][player][enemy 0 .. enemy n-1][bullet 0 .. bullet m-1]
+ *
+ * Taking or restoring one is a handful of memcpys. The buffer keeps its
+ * capacity between uses, so a snapshot that is reused doesn't allocate once
+ * it has seen its largest scene.
+ */
+class Snapshot {
+private:
+    std::vector<unsigned char> data;
+
+public:
+    void resize(int enemy_count, int bullet_count);
+    void reserve(int entity_count);
+    void load(const unsigned char *bytes, size_t size);
+
+    SnapshotHeader       *get_header()         { return (SnapshotHeader *) data.data(); };
+    const SnapshotHeader *get_header()   const { return (const SnapshotHeader *) data.data(); };
+    EntitySnapshot       *get_entities()       { return (EntitySnapshot *) (data.data() + sizeof(SnapshotHeader)); };
+    const EntitySnapshot *get_entities() const { return (const EntitySnapshot *) (data.data() + sizeof(SnapshotHeader)); };
+
+    static size_t size_for(int entity_count) { return sizeof(SnapshotHeader) + sizeof(EntitySnapshot) * entity_count; };
+
+    const unsigned char *get_data() const { return data.data();  };
+    size_t const         get_size() const { return data.size();  };
+    bool const           is_empty() const { return data.empty(); };
+};
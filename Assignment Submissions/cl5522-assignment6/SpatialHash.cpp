@@ -0,0 +1,65 @@
+#include <math.h>
+#include "SpatialHash.h"
+
+int const SpatialHash::hash_cell(int cell_x, int cell_y) const
+{
+    // Two large primes, so neighbouring cells land far apart
+    unsigned int hash = ((unsigned int) cell_x * 73856093u) ^ ((unsigned int) cell_y * 19349663u);
+    return (int) (hash & (unsigned int) bucket_mask);
+}
+
+int const SpatialHash::get_bucket_of(float x, float y) const
+{
+    return hash_cell((int) floorf(x / cell_size), (int) floorf(y / cell_size));
+}
+
+void SpatialHash::build(const float *x, const float *y, int count, float new_cell_size)
+{
+    cell_size = new_cell_size;
+
+    // Step 1: About two buckets per point keeps sharing down
+    int bucket_count = 16;
+    while (bucket_count < count * 2) bucket_count *= 2;
+    bucket_mask = bucket_count - 1;
+
+    bucket_starts.assign(bucket_count + 1, 0);
+    point_buckets.resize(count);
+    order.resize(count);
+
+    // Step 2: Count the points in each bucket...
+    for (int i = 0; i < count; i++)
+    {
+        point_buckets[i] = get_bucket_of(x[i], y[i]);
+        bucket_starts[point_buckets[i] + 1]++;
+    }
+
+    // ...turn the counts into where each bucket starts...
+    for (int b = 0; b < bucket_count; b++) bucket_starts[b + 1] += bucket_starts[b];
+
+    // ...and drop the points in, using the start of the next bucket as each one's write position
+    for (int i = 0; i < count; i++) order[bucket_starts[point_buckets[i]]++] = i;
+
+    // Which has left every start where the next bucket's should be, so shift them back
+    for (int b = bucket_count; b > 0; b--) bucket_starts[b] = bucket_starts[b - 1];
+    bucket_starts[0] = 0;
+}
+
+int const SpatialHash::get_neighbour_buckets(float x, float y, int *buckets) const
+{
+    int cell_x = (int) floorf(x / cell_size), cell_y = (int) floorf(y / cell_size);
+    int bucket_count = 0;
+
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int bucket = hash_cell(cell_x + dx, cell_y + dy);
+
+            // Two of the cells may share a bucket; it only counts once
+            bool is_new = true;
+            for (int i = 0; i < bucket_count; i++) is_new = is_new && buckets[i] != bucket;
+            if (is_new) buckets[bucket_count++] = bucket;
+        }
+    }
+    return bucket_count;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+
+/**
+ * A uniform grid over points, stored sparsely: each grid cell is hashed
+ * into one of a power-of-two number of buckets, so the world can be any
+ * size and only buckets with points in them cost anything.
+ *
+ * build() sorts the points by bucket (a counting sort, so O(n) and no
+ * per-point allocation once the vectors have grown), which leaves every
+ * bucket as one run of get_order(). With the cell size set to the search
+ * radius, everything within that radius of a point is in the 3x3 cells
+ * around it. Different cells can share a bucket, so whatever is found
+ * still has to be checked for distance.
+ */
+class SpatialHash {
+public:
+    // Rebuilds the buckets for the `count` points (x[i], y[i])
+    void build(const float *x, const float *y, int count, float cell_size);
+
+    // The buckets of the 3x3 cells around (x, y), each once; returns how many (up to 9)
+    int const get_neighbour_buckets(float x, float y, int *buckets) const;
+
+    // Bucket b holds the points get_order()[get_begin(b)] .. get_order()[get_end(b) - 1]
+    int const get_begin(int bucket) const { return bucket_starts[bucket];     };
+    int const get_end(int bucket)   const { return bucket_starts[bucket + 1]; };
+    int const get_bucket_of(float x, float y) const;
+
+    const std::vector<int> &get_order() const { return order; };
+    int const get_bucket_count() const { return bucket_mask + 1; };
+
+private:
+    float cell_size = 1.0f;
+    int bucket_mask = 0;
+
+    std::vector<int> bucket_starts; // bucket_count + 1 entries
+    std::vector<int> point_buckets;
+    std::vector<int> order;
+
+    int const hash_cell(int cell_x, int cell_y) const;
+};
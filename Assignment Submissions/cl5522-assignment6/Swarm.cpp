@@ -0,0 +1,209 @@
+#include <math.h>
+#include "Swarm.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SWARM_USE_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC and Clang only emit SSE instructions in functions that ask for them
+#if defined(SWARM_USE_X86) && defined(__GNUC__)
+#define SSE_FUNCTION __attribute__((target("sse2")))
+#else
+#define SSE_FUNCTION
+#endif
+
+// By AIType; only the ones is_swarming() says yes to are used.
+// Aliens leave the chasing to their script, big aliens hunt as a pack
+static const Swarm::Rule rules[] = {
+    //  radius  separation  alignment  cohesion  pursuit
+    {   0.0f,   0.0f,       0.0f,      0.0f,     0.0f },  // WALKER
+    {   0.0f,   0.0f,       0.0f,      0.0f,     0.0f },  // GUARD
+    {   1.5f,   1.0f,       0.5f,      0.2f,     0.0f },  // ASTEROID
+    {   1.5f,   1.5f,       0.8f,      0.4f,     0.0f },  // ALIEN
+    {   2.5f,   2.0f,       0.5f,      0.3f,     1.0f },  // BIG_ALIEN
+};
+
+const Swarm::Rule &Swarm::get_rule(AIType ai_type)
+{
+    return rules[ai_type];
+}
+
+// What one agent sees of its neighbours, as offsets from it
+struct NeighbourSums
+{
+    float count;
+    float separation_x, separation_y; // sum of -offset / distance^2: pushes harder the closer they are
+    float offset_x, offset_y;         // sum of offsets, for the centre
+    float velocity_x, velocity_y;     // sum of velocities, for the heading
+};
+
+/**
+ KERNELS
+ Sum up the neighbours in [first, end) of the bucket-ordered arrays that
+ are within sqrt(radius_squared) of (x, y), not counting (x, y) itself.
+ Each returns the index it got to, for the scalar one to finish off.
+ */
+static int accumulate_scalar(const float *xs, const float *ys, const float *vxs, const float *vys, int first, int end,
+                             float x, float y, float radius_squared, NeighbourSums *sums)
+{
+    for (int j = first; j < end; j++)
+    {
+        float dx = xs[j] - x, dy = ys[j] - y;
+        float distance_squared = dx * dx + dy * dy;
+        if (distance_squared >= radius_squared || distance_squared == 0.0f) continue;
+
+        sums->count        += 1.0f;
+        sums->separation_x -= dx / distance_squared;
+        sums->separation_y -= dy / distance_squared;
+        sums->offset_x     += dx;
+        sums->offset_y     += dy;
+        sums->velocity_x   += vxs[j];
+        sums->velocity_y   += vys[j];
+    }
+    return end;
+}
+
+#ifdef SWARM_USE_X86
+SSE_FUNCTION static float horizontal_sum(__m128 v)
+{
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums     = _mm_add_ps(v, shuffled);
+    shuffled        = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+SSE_FUNCTION static int accumulate_sse(const float *xs, const float *ys, const float *vxs, const float *vys, int first, int end,
+                                       float x, float y, float radius_squared, NeighbourSums *sums)
+{
+    __m128 centre_x = _mm_set1_ps(x), centre_y = _mm_set1_ps(y);
+    __m128 radius2 = _mm_set1_ps(radius_squared), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    __m128 count = zero, separation_x = zero, separation_y = zero, offset_x = zero, offset_y = zero, velocity_x = zero, velocity_y = zero;
+
+    int j = first;
+    for (; j + 4 <= end; j += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + j), centre_x);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + j), centre_y);
+        __m128 distance_squared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+        // Lanes outside the radius, or on top of us, count for nothing. Ours divides by
+        // zero below, but the mask clears whatever that gives
+        __m128 in_range = _mm_and_ps(_mm_cmplt_ps(distance_squared, radius2), _mm_cmpgt_ps(distance_squared, zero));
+        __m128 inverse  = _mm_and_ps(_mm_div_ps(one, distance_squared), in_range);
+
+        count        = _mm_add_ps(count,        _mm_and_ps(one, in_range));
+        separation_x = _mm_sub_ps(separation_x, _mm_mul_ps(dx, inverse));
+        separation_y = _mm_sub_ps(separation_y, _mm_mul_ps(dy, inverse));
+        offset_x     = _mm_add_ps(offset_x,     _mm_and_ps(dx, in_range));
+        offset_y     = _mm_add_ps(offset_y,     _mm_and_ps(dy, in_range));
+        velocity_x   = _mm_add_ps(velocity_x,   _mm_and_ps(_mm_loadu_ps(vxs + j), in_range));
+        velocity_y   = _mm_add_ps(velocity_y,   _mm_and_ps(_mm_loadu_ps(vys + j), in_range));
+    }
+
+    sums->count        += horizontal_sum(count);
+    sums->separation_x += horizontal_sum(separation_x);
+    sums->separation_y += horizontal_sum(separation_y);
+    sums->offset_x     += horizontal_sum(offset_x);
+    sums->offset_y     += horizontal_sum(offset_y);
+    sums->velocity_x   += horizontal_sum(velocity_x);
+    sums->velocity_y   += horizontal_sum(velocity_y);
+    return j;
+}
+#endif
+
+/**
+ STEERING
+ */
+void Swarm::steer(Entity *const *batch, int count, AIType ai_type, Entity *player, float delta_time)
+{
+    const Rule &rule = get_rule(ai_type);
+    EntityStore &store = Entity::store;
+
+    // Step 1: Copy out everyone still taking part
+    agents.clear();
+    x.clear();
+    y.clear();
+    velocity_x.clear();
+    velocity_y.clear();
+    for (int i = 0; i < count; i++)
+    {
+        if (!batch[i]->get_updating_state()) continue;
+
+        int slot = batch[i]->get_slot();
+        agents.push_back(batch[i]);
+        x.push_back(store.position_x[slot]);
+        y.push_back(store.position_y[slot]);
+        velocity_x.push_back(store.velocity_x[slot]);
+        velocity_y.push_back(store.velocity_y[slot]);
+    }
+
+    int agent_count = (int) agents.size();
+    if (agent_count == 0) return;
+
+    // Step 2: Bucket them, and lay them out in bucket order so each bucket is one run
+    hash.build(x.data(), y.data(), agent_count, rule.radius);
+    const std::vector<int> &order = hash.get_order();
+
+    sorted_x.resize(agent_count);
+    sorted_y.resize(agent_count);
+    sorted_vx.resize(agent_count);
+    sorted_vy.resize(agent_count);
+    for (int k = 0; k < agent_count; k++)
+    {
+        sorted_x[k]  = x[order[k]];
+        sorted_y[k]  = y[order[k]];
+        sorted_vx[k] = velocity_x[order[k]];
+        sorted_vy[k] = velocity_y[order[k]];
+    }
+
+    float radius_squared = rule.radius * rule.radius;
+    glm::vec3 player_position = player->get_position();
+    bool use_sse = store.get_isa() != EntityStore::ISA_SCALAR;
+
+    // Step 3: Sum up each one's neighbours and turn that into where it wants to go
+    for (int i = 0; i < agent_count; i++)
+    {
+        Entity *agent = agents[i];
+        NeighbourSums sums = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+        int buckets[9];
+        int bucket_count = hash.get_neighbour_buckets(x[i], y[i], buckets);
+        for (int b = 0; b < bucket_count; b++)
+        {
+            int j = hash.get_begin(buckets[b]), end = hash.get_end(buckets[b]);
+#ifdef SWARM_USE_X86
+            if (use_sse) j = accumulate_sse(sorted_x.data(), sorted_y.data(), sorted_vx.data(), sorted_vy.data(), j, end, x[i], y[i], radius_squared, &sums);
+#endif
+            accumulate_scalar(sorted_x.data(), sorted_y.data(), sorted_vx.data(), sorted_vy.data(), j, end, x[i], y[i], radius_squared, &sums);
+        }
+
+        glm::vec3 steering = glm::vec3(sums.separation_x, sums.separation_y, 0.0f) * rule.separation;
+
+        if (sums.count > 0.0f)
+        {
+            // Towards the middle of the neighbours, and (in movement units) towards their average heading
+            steering += glm::vec3(sums.offset_x, sums.offset_y, 0.0f) * (rule.cohesion / sums.count);
+            if (agent->speed > 0.0f)
+            {
+                glm::vec3 heading = glm::vec3(sums.velocity_x / sums.count - velocity_x[i], sums.velocity_y / sums.count - velocity_y[i], 0.0f);
+                steering += heading * (rule.alignment / agent->speed);
+            }
+        }
+
+        if (rule.pursuit > 0.0f)
+        {
+            glm::vec3 to_player = player_position - glm::vec3(x[i], y[i], 0.0f);
+            float distance = glm::length(to_player);
+            if (distance > 0.0f) steering += to_player * (rule.pursuit / distance);
+        }
+
+        // Step 4: Turn, but no faster than full speed
+        glm::vec3 movement = agent->get_movement() + steering * delta_time;
+        float length = glm::length(movement);
+        if (length > 1.0f) movement /= length;
+
+        agent->set_movement(movement);
+        agent->set_velocity(movement * agent->speed);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include "Entity.h"
+#include "SpatialHash.h"
+
+/**
+ * Flocking for the enemy fields: asteroids, aliens and big aliens steer
+ * away from neighbours that are too close (separation), towards their
+ * neighbours' average heading (alignment) and centre (cohesion), and, for
+ * some, after the player (pursuit).
+ *
+ * Each step, the batch's positions and velocities are copied out in
+ * SpatialHash bucket order, so every bucket's neighbours are one run of
+ * floats, and the forces are summed over those runs four at a time with
+ * SSE where the store says the CPU has it. The result is written back as
+ * each entity's movement (and velocity), which the usual move then
+ * applies, so the flock only ever changes where enemies want to go.
+ *
+ * Only enemies of the same archetype flock together, since that's what a
+ * batch is.
+ */
+class Swarm {
+public:
+    struct Rule
+    {
+        float radius;     // how far a neighbour can be
+        float separation; // how hard each force pulls
+        float alignment;
+        float cohesion;
+        float pursuit;
+    };
+
+    static bool const is_swarming(AIType ai_type) { return ai_type == ASTEROID || ai_type == ALIEN || ai_type == BIG_ALIEN; };
+    static const Rule &get_rule(AIType ai_type);
+
+    // Steers every updating entity in `batch`, all of `ai_type`
+    void steer(Entity *const *batch, int count, AIType ai_type, Entity *player, float delta_time);
+
+private:
+    SpatialHash hash;
+
+    // Work space, kept so stepping doesn't allocate
+    std::vector<Entity*> agents;
+    std::vector<float> x, y, velocity_x, velocity_y;                 // in batch order
+    std::vector<float> sorted_x, sorted_y, sorted_vx, sorted_vy;     // in bucket order
+};
@@ -0,0 +1,301 @@
+#include <limits.h>
+#include "UpdateSystem.h"
+#include "PerfStats.h"
+#include "EnemyBehaviours.h"
+#include "Swarm.h"
+
+// Work space for the flocking enemies; only ever used by one system at a time
+static Swarm swarm;
+
+// What the enemies being updated can see, for as long as update_entities() is running
+static VisibilityCache *current_visibility = NULL;
+
+// Types that move and collide; the rest only animate
+static constexpr bool moves(EntityType type) { return type == PLAYER || type == ENEMY || type == GREEN_LASER; }
+
+/**
+ PER-ENTITY PARTS
+ */
+template <AIType AI>
+void Entity::run_ai(Entity *player, float delta_time)
+{
+    if (!behaviour.is_started()) behaviour = start_behaviour(AI, this, player);
+    behaviour.tick(this, player, delta_time, current_visibility);
+}
+
+// Everything before moving. Returns whether we are still around to move
+template <EntityType TYPE, AIType AI>
+bool Entity::begin_update(float delta_time, Entity *player)
+{
+    if (lives <= 0) {
+        deactivate();
+    }
+
+    is_updating = is_active;
+    if (!is_active) return false;
+
+    PerfStats::count_update();
+
+    previous_rotation = rotation;
+
+    float &velocity_x = store.velocity_x[slot], &velocity_y = store.velocity_y[slot];
+
+    acceleration = glm::vec3(0.0f);
+    move_rotate = glm::radians(0.0f);
+ 
+    collided_top    = false;
+    collided_bottom = false;
+    collided_left   = false;
+    collided_right  = false;
+    
+    // Keep doing what we were doing if it isn't our turn to think
+    if (TYPE == ENEMY)
+    {
+        ai_elapsed += delta_time;
+        if (!is_skipping_ai) {
+            run_ai<AI>(player, ai_elapsed);
+            ai_elapsed = 0.0f;
+        }
+        is_skipping_ai = false;
+    }
+    
+    if (animation_indices != NULL)
+    {
+        if (glm::length(movement) != 0)
+        {
+            animation_time += delta_time;
+            float frames_per_second = (float) 1 / SECONDS_PER_FRAME;
+            
+            if (animation_time >= frames_per_second)
+            {
+                animation_time = 0.0f;
+                animation_index++;
+                
+                if (animation_index >= animation_frames)
+                {
+                    animation_index = 0;
+                }
+            }
+        }
+    }
+
+    if (TYPE == PLAYER) {
+        //Thrust
+        if (is_thrusting_up) {
+            //Step 1: Immediately return the flag to its originial false state
+            is_thrusting_up = false;
+            //Step 2: The player now acquires an upward velocity
+            acceleration.y = thrusting_power;
+        }
+        else if (is_thrusting_down) {
+            is_thrusting_down = false;
+            acceleration.y = -thrusting_power;
+        }
+
+        if (is_thrusting_left) {
+            is_thrusting_left = false;
+            acceleration.x = -thrusting_power;
+        }
+        else if (is_thrusting_right) {
+            is_thrusting_right = false;
+            acceleration.x = thrusting_power;
+        }
+        else {
+            acceleration.x = 0;
+        }
+
+        if (is_rotating_counter) {
+            is_rotating_counter = false;
+            move_rotate += rotate_speed;
+            rotation += rotate_speed;
+            if (rotation >= glm::radians(360.0)) {
+                rotation -= glm::radians(360.0);
+            }
+        }
+        else if (is_rotating_clock) {
+            is_rotating_clock = false;
+            move_rotate -= rotate_speed;
+            rotation -= rotate_speed;
+            if (rotation <= glm::radians(-360.0)) {
+                rotation += glm::radians(360.0);
+            }
+        }
+
+        // Now we add the rest of the gravity physics
+        velocity_x += acceleration.x * delta_time;
+        velocity_y += acceleration.y * delta_time;
+    }
+
+    if (TYPE == ENEMY) {
+        velocity_x = movement.x * speed;
+        velocity_y = movement.y * speed;
+    }
+
+    if (TYPE == GREEN_LASER) {
+        velocity_y = glm::cos(rotation) * speed;
+        velocity_x = -glm::sin(rotation) * speed;
+    }
+
+    return true;
+}
+
+// Everything after moving
+template <EntityType TYPE>
+void Entity::end_update()
+{
+    model_matrix = glm::mat4(1.0f);
+    model_matrix = glm::translate(model_matrix, get_position());
+    if (TYPE == PLAYER) model_matrix = glm::rotate(model_matrix, rotation, glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+/**
+ SYSTEMS
+ */
+template <EntityType TYPE, AIType AI>
+void update_system(Entity *const *batch, int count, float delta_time, Entity *player, Entity *objects, int object_count, ContactList *contacts)
+{
+    EntityStore &store = Entity::store;
+
+    // Step 1: Work out where everyone wants to go, noting which store slots they sit in
+    int live_count = 0, first_slot = INT_MAX, last_slot = -1;
+    for (int i = 0; i < count; i++)
+    {
+        if (!batch[i]->begin_update<TYPE, AI>(delta_time, player)) continue;
+
+        int slot = batch[i]->slot;
+        live_count++;
+        if (slot < first_slot) first_slot = slot;
+        if (slot > last_slot)  last_slot  = slot;
+    }
+
+    if (!moves(TYPE) || live_count == 0) return;
+
+    // Slots are unique, so if they span exactly live_count of them, that run is all ours
+    bool is_contiguous = last_slot - first_slot + 1 == live_count;
+
+    // Step 2: Flock, for the kinds of enemy that do
+    if (TYPE == ENEMY && Swarm::is_swarming(AI)) swarm.steer(batch, count, AI, player, delta_time);
+
+    // Step 3: Move
+    if (is_contiguous)
+    {
+        store.integrate_y(first_slot, live_count, delta_time);
+        store.integrate_x(first_slot, live_count, delta_time);
+    }
+    else
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int slot = batch[i]->slot;
+            if (!batch[i]->is_updating) continue;
+            store.position_y[slot] += store.velocity_y[slot] * delta_time;
+            store.position_x[slot] += store.velocity_x[slot] * delta_time;
+        }
+    }
+
+    // Step 4: Find what we ran into, once, then get out of it and deal the damage
+    contacts->generate(batch, count, objects, object_count, is_swept(TYPE) ? delta_time : 0.0f);
+    contacts->resolve();
+
+    // Step 5: Place the sprites
+    for (int i = 0; i < count; i++)
+    {
+        if (batch[i]->is_updating) batch[i]->end_update<TYPE>();
+    }
+
+    // Step 6: Whoever is still idle, standing still and untouched would do nothing
+    //         next step either, so stop updating them until the player comes near
+    if (wake_distance_for(TYPE, AI) > 0.0f)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            Entity *entity = batch[i];
+            if (!entity->is_updating || entity->lives <= 0 || entity->ai_state != IDLE) continue;
+            if (store.velocity_x[entity->slot] != 0.0f || store.velocity_y[entity->slot] != 0.0f || entity->movement != glm::vec3(0.0f)) continue;
+            if (entity->collided_top || entity->collided_bottom || entity->collided_left || entity->collided_right) continue;
+
+            entity->fall_asleep();
+        }
+    }
+}
+
+// Wakes the dormant entities of an archetype that the player has come near and is in sight of, or that have run out of lives
+static void wake_dormant(EntityRegistry *registry, EntityType type, AIType ai_type, Entity *player)
+{
+    const std::vector<Entity*> &dormant = registry->get_dormant(type, ai_type);
+    if (dormant.empty()) return;
+
+    EntityStore &store = Entity::store;
+    float wake_distance = wake_distance_for(type, ai_type);
+    float wake_distance_squared = wake_distance * wake_distance;
+    float player_x = store.position_x[player->get_slot()], player_y = store.position_y[player->get_slot()];
+
+    // Waking takes them off this list, so back to front
+    for (int i = (int) dormant.size() - 1; i >= 0; i--)
+    {
+        Entity *entity = dormant[i];
+        float x_distance = store.position_x[entity->get_slot()] - player_x;
+        float y_distance = store.position_y[entity->get_slot()] - player_y;
+
+        bool is_near = x_distance * x_distance + y_distance * y_distance < wake_distance_squared;
+        if ((is_near && (current_visibility == NULL || current_visibility->can_see(entity->get_position()))) || entity->get_lives() <= 0) entity->wake_up();
+    }
+}
+
+void run_update_system(EntityType type, AIType ai_type, Entity *const *batch, int count, float delta_time, Entity *player, Entity *objects, int object_count, ContactList *contacts)
+{
+    // Only enemies have an AI; everything else files under WALKER
+    switch (type)
+    {
+        case PLATFORM:    update_system<PLATFORM,    WALKER>(batch, count, delta_time, player, objects, object_count, contacts); break;
+        case PLAYER:      update_system<PLAYER,      WALKER>(batch, count, delta_time, player, objects, object_count, contacts); break;
+        case GREEN_LASER: update_system<GREEN_LASER, WALKER>(batch, count, delta_time, player, objects, object_count, contacts); break;
+        case RED_LASER:   update_system<RED_LASER,   WALKER>(batch, count, delta_time, player, objects, object_count, contacts); break;
+
+        case ENEMY:
+            switch (ai_type)
+            {
+                case WALKER:    update_system<ENEMY, WALKER>   (batch, count, delta_time, player, objects, object_count, contacts); break;
+                case GUARD:     update_system<ENEMY, GUARD>    (batch, count, delta_time, player, objects, object_count, contacts); break;
+                case ASTEROID:  update_system<ENEMY, ASTEROID> (batch, count, delta_time, player, objects, object_count, contacts); break;
+                case ALIEN:     update_system<ENEMY, ALIEN>    (batch, count, delta_time, player, objects, object_count, contacts); break;
+                case BIG_ALIEN: update_system<ENEMY, BIG_ALIEN>(batch, count, delta_time, player, objects, object_count, contacts); break;
+            }
+            break;
+    }
+}
+
+void update_entities(EntityRegistry *registry, EntityType type, std::vector<Entity*> *batch, float delta_time, Entity *player, Entity *objects, int object_count, ContactList *contacts, AIScheduler *scheduler, VisibilityCache *visibility)
+{
+    batch->clear();
+    current_visibility = visibility;
+
+    int ai_type_count = type == ENEMY ? EntityRegistry::AI_TYPE_COUNT : 1;
+    for (int ai_type = 0; ai_type < ai_type_count; ai_type++)
+    {
+        wake_dormant(registry, type, (AIType) ai_type, player);
+
+        const std::vector<Entity*> &active = registry->get_active(type, (AIType) ai_type);
+        if (active.empty()) continue;
+
+        size_t first = batch->size();
+        batch->insert(batch->end(), active.begin(), active.end());
+        if (type == ENEMY && scheduler != NULL) scheduler->schedule(batch->data() + first, (int) (batch->size() - first), (AIType) ai_type, player);
+        run_update_system(type, (AIType) ai_type, batch->data() + first, (int) (batch->size() - first), delta_time, player, objects, object_count, contacts);
+    }
+
+    current_visibility = NULL;
+}
+
+/**
+ ONE AT A TIME
+ */
+void Entity::update(float delta_time, Entity *player, Entity *objects, int object_count)
+{
+    // A step of its own, so nothing it hits has been hit yet this step
+    static ContactList contacts;
+    contacts.begin_step();
+    
+    Entity *self = this;
+    run_update_system(entity_type, ai_type, &self, 1, delta_time, player, objects, object_count, &contacts);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include "Entity.h"
+#include "EntityRegistry.h"
+#include "AIScheduler.h"
+#include "VisibilityCache.h"
+
+/**
+ * Entity updates, one archetype at a time.
+ *
+ * An archetype is an EntityType, plus the AIType for enemies. Every archetype
+ * gets its own compiled copy of the update, update_system<TYPE, AI>(), in
+ * which all the "what kind of entity is this" tests are constants, so a batch
+ * of entities of one archetype goes through without any per-entity branching
+ * on type. The movement itself runs as its own pass over the batch, through
+ * the EntityStore SIMD kernels when the batch fills a run of store slots,
+ * and collisions are found once afterwards into a ContactList.
+ *
+ * Picking the system (run_update_system) is done once per batch at run time.
+ */
+
+// Lasers move far enough in a step to skip clean over a small asteroid, so their whole path is checked for hits
+constexpr bool is_swept(EntityType type) { return type == GREEN_LASER || type == RED_LASER; }
+
+// How close the player has to come to wake a dormant entity of this archetype; 0 if it never sleeps.
+// Only idle guards sleep: they stand still until the player comes this close, where they can see them
+constexpr float wake_distance_for(EntityType type, AIType ai_type) { return type == ENEMY && ai_type == GUARD ? Entity::GUARD_WAKE_DISTANCE : 0.0f; }
+
+// One fixed step for `count` entities, all of archetype (TYPE, AI)
+template <EntityType TYPE, AIType AI>
+void update_system(Entity *const *batch, int count, float delta_time, Entity *player, Entity *objects, int object_count, ContactList *contacts);
+
+void run_update_system(EntityType type, AIType ai_type, Entity *const *batch, int count, float delta_time, Entity *player, Entity *objects, int object_count, ContactList *contacts);
+
+/**
+ * One fixed step for every active entity of `type` in the registry, one
+ * system per archetype. The systems switch entities off as they go, which
+ * reorders the registry's lists, so they work on a copy: `batch` is left
+ * holding everything that was updated, including whatever switched off.
+ *
+ * Dormant entities are skipped. Before each system runs, the ones the
+ * player has come near (or that have run out of lives) are woken up and
+ * updated with the rest, so they catch up on the same step.
+ *
+ * With a scheduler, enemies only run their AI when it gives them a tick;
+ * without one they all think every step. With a visibility cache, walls
+ * block what enemies can see of the player; without one they see through.
+ */
+void update_entities(EntityRegistry *registry, EntityType type, std::vector<Entity*> *batch, float delta_time, Entity *player, Entity *objects, int object_count, ContactList *contacts, AIScheduler *scheduler = NULL, VisibilityCache *visibility = NULL);
@@ -1,14 +1,19 @@
 #define LOG(argument) std::cout << argument << '\n'
 #define STB_IMAGE_IMPLEMENTATION
-#define NUMBER_OF_TEXTURES 1 // to be generated, that is
-#define LEVEL_OF_DETAIL 0    // base image level; Level n is the nth mipmap reduction image
-#define TEXTURE_BORDER 0     // this value MUST be zero
+#define STBI_MALLOC(size)           AllocationTracker::allocate(size)
+#define STBI_REALLOC(pointer, size) AllocationTracker::reallocate(pointer, size)
+#define STBI_FREE(pointer)          AllocationTracker::release(pointer)
 #define FONTBANK_SIZE 16
 
 #include "Utility.h"
+#include <string.h>
 #include <SDL_image.h>
+#include "AllocationTracker.h"
 #include "stb_image.h"
 
+Arena Utility::frame_arena(FRAME_ARENA_SIZE);
+RenderDevice *Utility::device = NULL;
+
 GLuint Utility::load_texture(const char* filepath) {
     // STEP 1: Loading the image file
     int width, height, number_of_components;
@@ -20,85 +25,71 @@ GLuint Utility::load_texture(const char* filepath) {
         assert(false);
     }
     
-    // STEP 2: Generating and binding a texture ID to our image
-    GLuint texture_id;
-    glGenTextures(NUMBER_OF_TEXTURES, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, image);
-    
-    // STEP 3: Setting our texture filter modes
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    
-    // STEP 4: Setting our texture wrapping modes
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // the last argument can change depending on what you are looking for
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // STEP 2: Handing it to the device, which makes the texture (filter and wrapping modes included)
+    GLuint texture_id = device->create_texture(width, height, image);
     
-    // STEP 5: Releasing our file from memory and returning our texture id
+    // STEP 3: Releasing our file from memory and returning our texture id
     stbi_image_free(image);
     
     return texture_id;
 }
 
-void Utility::draw_text(ShaderProgram *program, GLuint font_texture_id, std::string text, float screen_size, float spacing, glm::vec3 position)
+void Utility::draw_text(ShaderProgram *program, RenderQueue *queue, GLuint font_texture_id, const char *text, float screen_size, float spacing, glm::vec3 position)
 {
-    // Scale the size of the fontbank in the UV-plane
-    // We will use this for spacing and positioning
-    float width = 1.0f / FONTBANK_SIZE;
-    float height = 1.0f / FONTBANK_SIZE;
+    // Instead of having a single pair of arrays, we'll have a series of pairs—one for each character.
+    // The UVs themselves are worked out by the vertex shader from each character's index in the fontbank,
+    // so all we hand it is the corner of the glyph each vertex sits on
+    // The arrays only have to last until the queue is submitted, so they come out of this frame's scratch arena
+    int length = (int) strlen(text);
+    int vertex_count = length * 6;
+    float *vertices            = frame_arena.create_array<float>(vertex_count * 2);
+    float *texture_coordinates = frame_arena.create_array<float>(vertex_count * 2);
+    float *glyph_indices       = frame_arena.create_array<float>(vertex_count);
 
-    // Instead of having a single pair of arrays, we'll have a series of pairs—one for each character
-    // Don't forget to include <vector>!
-    std::vector<float> vertices;
-    std::vector<float> texture_coordinates;
+    static const float glyph_corners[] =
+    {
+        0.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 0.0f,
+        1.0f, 1.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+    };
 
     // For every character...
-    for (int i = 0; i < text.size(); i++) {
+    for (int i = 0; i < length; i++) {
         // 1. Get their index in the spritesheet, as well as their offset (i.e. their position
         //    relative to the whole sentence)
-        int spritesheet_index = (int) text[i];  // ascii value of character
+        float spritesheet_index = (float) text[i];  // ascii value of character
         float offset = (screen_size + spacing) * i;
-        
-        // 2. Using the spritesheet index, we can calculate our U- and V-coordinates
-        float u_coordinate = (float) (spritesheet_index % FONTBANK_SIZE) / FONTBANK_SIZE;
-        float v_coordinate = (float) (spritesheet_index / FONTBANK_SIZE) / FONTBANK_SIZE;
 
-        // 3. Inset the current pair in both vectors
-        vertices.insert(vertices.end(), {
+        // 2. Write the current pair into both arrays
+        const float glyph_vertices[] =
+        {
             offset + (-0.5f * screen_size), 0.5f * screen_size,
             offset + (-0.5f * screen_size), -0.5f * screen_size,
             offset + (0.5f * screen_size), 0.5f * screen_size,
             offset + (0.5f * screen_size), -0.5f * screen_size,
             offset + (0.5f * screen_size), 0.5f * screen_size,
             offset + (-0.5f * screen_size), -0.5f * screen_size,
-        });
+        };
+
+        for (int j = 0; j < 12; j++) {
+            vertices[i * 12 + j]            = glyph_vertices[j];
+            texture_coordinates[i * 12 + j] = glyph_corners[j];
+        }
 
-        texture_coordinates.insert(texture_coordinates.end(), {
-            u_coordinate, v_coordinate,
-            u_coordinate, v_coordinate + height,
-            u_coordinate + width, v_coordinate,
-            u_coordinate + width, v_coordinate + height,
-            u_coordinate + width, v_coordinate,
-            u_coordinate, v_coordinate + height,
-        });
+        // 3. Every vertex of the glyph carries the same fontbank index
+        for (int j = 0; j < 6; j++) glyph_indices[i * 6 + j] = spritesheet_index;
     }
 
-    // 4. And render all of them using the pairs
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, position);
-    
-    program->SetModelMatrix(model_matrix);
-    glUseProgram(program->programID);
-    
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices.data());
-    glEnableVertexAttribArray(program->positionAttribute);
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, texture_coordinates.data());
-    glEnableVertexAttribArray(program->texCoordAttribute);
-    
-    glBindTexture(GL_TEXTURE_2D, font_texture_id);
-    glDrawArrays(GL_TRIANGLES, 0, (int) (text.size() * 6));
-    
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
+    // 4. And queue all of them up as one command
+    RenderCommand *command = queue->add(program, RENDER_LAYER_UI, font_texture_id);
+    command->model_matrix        = glm::translate(glm::mat4(1.0f), position);
+    command->vertices            = vertices;
+    command->texture_coordinates = texture_coordinates;
+    command->vertex_count        = vertex_count;
+    command->sprite_cols         = FONTBANK_SIZE;
+    command->sprite_rows         = FONTBANK_SIZE;
+    command->sprite_indices      = glyph_indices;
 }
-
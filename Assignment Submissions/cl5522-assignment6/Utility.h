@@ -12,9 +12,19 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "Arena.h"
+#include "RenderQueue.h"
+
+#define FRAME_ARENA_SIZE (64 * 1024)
 
 class Utility {
 public:
+    // Scratch memory for one frame's draw calls, reset at the start of every frame
+    static Arena frame_arena;
+    
+    // What load_texture() makes textures on; main points it at the device it draws with
+    static RenderDevice *device;
+    
     static GLuint load_texture(const char* filepath);
-    static void draw_text(ShaderProgram *program, GLuint font_texture_id, std::string text, float screen_size, float spacing, glm::vec3 position);
+    static void draw_text(ShaderProgram *program, RenderQueue *queue, GLuint font_texture_id, const char *text, float screen_size, float spacing, glm::vec3 position);
 };
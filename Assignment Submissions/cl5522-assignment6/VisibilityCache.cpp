@@ -0,0 +1,42 @@
+#include "VisibilityCache.h"
+#include "PerfStats.h"
+
+void VisibilityCache::begin_step(const Map *map, glm::vec3 target)
+{
+    this->target = target;
+    step++;
+
+    // A different map (or the first one): none of the answers are any good
+    if (map != this->map || (map != NULL && (int) tile_steps.size() != map->get_width() * map->get_height()))
+    {
+        this->map = map;
+        size_t tile_count = map != NULL ? (size_t) map->get_width() * map->get_height() : 0;
+        tile_steps.assign(tile_count, 0);
+        tile_answers.assign(tile_count, 0);
+        step = 1;
+    }
+}
+
+bool VisibilityCache::can_see(glm::vec3 from)
+{
+    if (map == NULL) return true;
+
+    int tile_x = map->get_tile_x(from.x), tile_y = map->get_tile_y(from.y);
+    if (tile_x < 0 || tile_x >= map->get_width() || tile_y < 0 || tile_y >= map->get_height())
+    {
+        PerfStats::count_sight(false);
+        return !map->raycast(from, target);
+    }
+
+    int tile = tile_y * map->get_width() + tile_x;
+    if (tile_steps[tile] == step)
+    {
+        PerfStats::count_sight(true);
+        return tile_answers[tile];
+    }
+
+    PerfStats::count_sight(false);
+    tile_steps[tile] = step;
+    tile_answers[tile] = !map->raycast(map->get_tile_centre(tile_x, tile_y), target);
+    return tile_answers[tile];
+}
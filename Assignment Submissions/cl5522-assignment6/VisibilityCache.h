@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include "Map.h"
+
+/**
+ * Whether the player can be seen, worked out once per tile per step.
+ *
+ * Lines of sight are cast through the Map from the centre of the looker's
+ * tile to the target, so every enemy standing on the same tile gets the
+ * same answer and only the first one to ask pays for the ray. Answers are
+ * kept one per map tile, stamped with the step they are from, so starting
+ * a step is just moving the stamp on.
+ *
+ * Without a map nothing blocks the view and everyone can see the target.
+ * Lookers off the edge of the map cast their own ray every time.
+ */
+class VisibilityCache {
+public:
+    // The target is where the player is for this step
+    void begin_step(const Map *map, glm::vec3 target);
+
+    bool can_see(glm::vec3 from);
+
+private:
+    const Map *map = NULL;
+    glm::vec3 target;
+    int step = 0;
+
+    std::vector<int> tile_steps; // the step each answer is from
+    std::vector<unsigned char> tile_answers;
+};
@@ -31,7 +31,7 @@ void WinScreen::initialise()
      George's Stuff
      */
      // Existing
-    state.player = new Entity();
+    state.player = arena.create<Entity>();
     state.player->set_entity_type(PLAYER);
     state.player->set_position(glm::vec3(5.0f, 0.0f, 0.0f));
     state.player->set_movement(glm::vec3(0.0f));
@@ -41,10 +41,10 @@ void WinScreen::initialise()
     state.player->deactivate();
 
     // Walking
-    state.player->walking[state.player->LEFT] = new int[4]{ 1, 5, 9,  13 };
-    state.player->walking[state.player->RIGHT] = new int[4]{ 3, 7, 11, 15 };
-    state.player->walking[state.player->UP] = new int[4]{ 2, 6, 10, 14 };
-    state.player->walking[state.player->DOWN] = new int[4]{ 0, 4, 8,  12 };
+    state.player->walking[state.player->LEFT] = arena.copy_array<int>({ 1, 5, 9,  13 });
+    state.player->walking[state.player->RIGHT] = arena.copy_array<int>({ 3, 7, 11, 15 });
+    state.player->walking[state.player->UP] = arena.copy_array<int>({ 2, 6, 10, 14 });
+    state.player->walking[state.player->DOWN] = arena.copy_array<int>({ 0, 4, 8,  12 });
 
     state.player->animation_indices = state.player->walking[state.player->RIGHT];  // start George looking left
     state.player->animation_frames = 4;
@@ -87,7 +87,7 @@ void WinScreen::initialise()
 
 void WinScreen::update(float delta_time) {}
 
-void WinScreen::render(ShaderProgram* program)
+void WinScreen::render(ShaderProgram *program, RenderQueue *queue, float alpha)
 {
-    Utility::draw_text(program, main_menu_text_texture_id, "You Win!", 0.75f, 0.1f, glm::vec3(2.0f, -3.7f, 0.0f));
+    Utility::draw_text(program, queue, main_menu_text_texture_id, "You Win!", 0.75f, 0.1f, glm::vec3(2.0f, -3.7f, 0.0f));
 }
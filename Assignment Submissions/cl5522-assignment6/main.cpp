@@ -21,6 +21,24 @@ The following music was used for this media project:
 #define LEVEL1_WIDTH 14
 #define LEVEL1_HEIGHT 8
 #define LEVEL1_LEFT_EDGE 5.0f
+#define REWIND_SECONDS 10
+#define REWIND_STORAGE (4 * 1024 * 1024) // holds REWIND_SECONDS while under ~7 KB changes a step, see --rewind-check
+#define ALLOC_CHECK_WARMUP 120   // steps after a scene change that may still allocate
+#define ALLOC_CHECK_FIRE_EVERY 6
+#define RENDER_QUEUE_CAPACITY 512
+#define RENDER_BUDGET_STEPS 600
+#define SWARM_BENCHMARK_STEPS 600
+#define PATH_BENCHMARK_PATHS 200
+#define PATH_BENCHMARK_ROOM 20       // room size of the benchmark map, walls included
+#define PARTICLE_BENCHMARK_STEPS 600
+#define PARTICLE_BENCHMARK_BUDGET_MS 2.0 // particles' share of a step
+#define SIGHT_CHECK_WIDTH 12
+#define SIGHT_CHECK_HEIGHT 6
+#define SIGHT_CHECK_STEPS 30         // steps a guard has to not see through the wall
+#define REWIND_CHECK_MOVING_EVERY 20 // one entity in this many moves every step, the rest stand still
+#define TARGET_FPS 120.0f           // --fps <n> to change, --fps 0 for uncapped
+#define IDLE_WAIT_MILLISECONDS 250 // longest a static screen sleeps waiting for input
+#define MAX_STEPS_PER_FRAME 4      // beyond this the game slows down instead of catching up
 
 
 #ifdef _WINDOWS
@@ -35,7 +53,10 @@ The following music was used for this media project:
 #include "ShaderProgram.h"
 #include "cmath"
 #include <ctime>
+#include <string.h>
+#include <stdlib.h>
 #include <vector>
+#include <algorithm>
 #include "Entity.h"
 #include "Map.h"
 #include "Utility.h"
@@ -46,6 +67,16 @@ The following music was used for this media project:
 #include "LevelC.h"
 #include "WinScreen.h"
 #include "LoseScreen.h"
+#include "InputRecorder.h"
+#include "RewindBuffer.h"
+#include "AllocationTracker.h"
+#include "GLRenderDevice.h"
+#include "NullRenderDevice.h"
+#include "PerfStats.h"
+#include "FramePacer.h"
+#include "UpdateSystem.h"
+#include "PathService.h"
+#include "EnemyBehaviours.h"
 
 
 /**
@@ -68,6 +99,7 @@ const char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
            F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
 
 const char BULLET_FILEPATH[] = "assets/green_laser.png";
+const char PERF_FONT_FILEPATH[] = "assets/text_sheet.png";
 
 const float MILLISECONDS_IN_SECOND = 1000.0;
 
@@ -89,55 +121,132 @@ int current_level_index;
 int current_lives = 3;
 
 int ammo = 200;
+GLuint bullet_texture_id;
+
+// F3 (or --perf) shows the frame's counters in the corner
+bool show_perf_overlay = false;
+GLuint perf_font_texture_id;
+
+// --alloc-check <steps>: play LevelA headless and fail on any allocation once it has settled
+int alloc_check_steps = 0;
+
+// --render-budget <draw calls>: play LevelA without drawing and fail if any frame needs more draw calls
+int render_budget = 0;
+
+// --swarm-benchmark <agents>: time a field of flocking enemies and fail if a step takes longer than a step
+int swarm_benchmark = 0;
+
+// --path-benchmark <size>: time paths across a size x size map, flat and through PathService
+int path_benchmark = 0;
+
+// --particle-benchmark <count>: time a full pool of particles and fail if a step takes more than its share
+int particle_benchmark = 0;
+
+// --sight-check: check lines of sight, and a guard waking, across a small map with a wall in it
+bool sight_check = false;
+
+// --rewind-check <count>: record REWIND_SECONDS of count entities and fail if the rewind storage can't hold it all
+int rewind_check = 0;
 
 
-SDL_Window* display_window;
 bool game_is_running = true;
 
 ShaderProgram program;
+RenderQueue render_queue(RENDER_QUEUE_CAPACITY);
+GLRenderDevice gl_device;
+NullRenderDevice null_device;
+RenderDevice *render_device = &gl_device;
 glm::mat4 view_matrix, projection_matrix;
 
 float previous_ticks = 0.0f;
 float accumulator = 0.0f;
 
+FramePacer frame_pacer(TARGET_FPS);
+bool needs_redraw = true;
+
+InputRecorder input_recorder;
+unsigned short live_buttons = 0;
+
+Snapshot level_start, quick_save;
+Scene *quick_save_scene = NULL;
+
+// Snapshots are sized for each scene as it starts, see switch_to_scene()
+RewindBuffer rewind_buffer((int) (REWIND_SECONDS / FIXED_TIMESTEP), REWIND_STORAGE, 0);
+Snapshot rewind_snapshot;
+bool rewind_overflowed = false; // reported once per scene
+
 void switch_to_scene(Scene *scene)
 {
     if (current_scene && current_level_index != 0) {
         if (current_scene->state.player->get_active_state()) current_lives = current_scene->state.player->get_lives();
     }
+
+    // Nothing of the old scene is needed past this point
+    if (current_scene) current_scene->release();
+
     current_scene = scene;
     current_scene->initialise();
     if (current_scene->state.player->get_active_state()) current_scene->state.player->set_lives(current_lives);
+
+    // Retrying the level is just putting this back
+    current_scene->save_snapshot(&level_start);
+    level_start.get_header()->ammo = ammo;
+    quick_save_scene = NULL;
+    
+    // Big enough for the scene plus every laser it can have in flight, so recording never allocates
+    int entity_count = 1 + current_scene->number_of_enemies + SCENE_MAX_BULLETS;
+    rewind_snapshot.reserve(entity_count);
+    rewind_buffer.reserve(Snapshot::size_for(entity_count));
+    rewind_buffer.clear();
+    rewind_overflowed = false;
+    needs_redraw = true;
 }
 
-void initialise()
+// The checks and benchmarks draw into the null device, with no window or GL context at all
+bool is_headless()
 {
-    SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
-    display_window = SDL_CreateWindow("Asteroid Destroyer!",
-                                      SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                                      WINDOW_WIDTH, WINDOW_HEIGHT,
-                                      SDL_WINDOW_OPENGL);
-    
-    SDL_GLContext context = SDL_GL_CreateContext(display_window);
-    SDL_GL_MakeCurrent(display_window, context);
-    
-#ifdef _WINDOWS
-    glewInit();
-#endif
+    return alloc_check_steps > 0 || render_budget > 0 || swarm_benchmark > 0 || path_benchmark > 0 || particle_benchmark > 0 || sight_check || rewind_check > 0;
+}
+
+// Static screens (menus) only change on input, so the loop sleeps and stops redrawing on them
+bool is_idle()
+{
+    return current_scene->is_static() && !show_perf_overlay && !input_recorder.is_replaying();
+}
+
+// False if there is no window to play in
+bool initialise()
+{
+    // SDL's allocations are counted along with everything else's
+    AllocationTracker::hook_sdl();
     
-    glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    if (is_headless()) {
+        // Nothing is seen or heard
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+        SDL_Init(SDL_INIT_AUDIO);
+        render_device = &null_device;
+    } else {
+        SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+        if (!gl_device.open("Asteroid Destroyer!", WINDOW_WIDTH, WINDOW_HEIGHT)) {
+            std::cout << "Could not open a window with a GL context: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        gl_device.set_viewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+        gl_device.set_clear_colour(0.0f, 0.0f, 0.0f, BG_OPACITY);
+    }
+    Utility::device = render_device;
     
-    program.Load(V_SHADER_PATH, F_SHADER_PATH);
+    render_device->load_program(&program, V_SHADER_PATH, F_SHADER_PATH);
     
     view_matrix = glm::mat4(1.0f);
     projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
     
-    program.SetProjectionMatrix(projection_matrix);
-    program.SetViewMatrix(view_matrix);
+    render_device->set_projection_matrix(&program, projection_matrix);
+    render_device->set_view_matrix(&program, view_matrix);
     
-    glUseProgram(program.programID);
-    
-    glClearColor(0.0f, 0.0f, 0.0f, BG_OPACITY);
+    // Every laser shares one texture
+    bullet_texture_id = Utility::load_texture(BULLET_FILEPATH);
+    perf_font_texture_id = Utility::load_texture(PERF_FONT_FILEPATH);
     
     main_menu = new MainMenu();
     level_a = new LevelA();
@@ -154,92 +263,102 @@ void initialise()
     levels[5] = lose_screen;
     switch_to_scene(levels[0]);
     current_level_index = 0;
-    
-    // enable blending
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    return true;
+}
+
+void spawn_bullet()
+{
+    if (!current_scene->state.player->get_active_state() || ammo == 0) return;
+    if (!current_scene->has_room_for_bullet()) return;
+
+    Mix_PlayChannel(-1, current_scene->state.jump_sfx, 0);
+    Entity* bullet = current_scene->create_bullet();
+    bullet->set_entity_type(GREEN_LASER);
+    bullet->set_position(current_scene->state.player->get_position());
+    bullet->set_movement(glm::vec3(0.0f));
+    bullet->rotation = current_scene->state.player->get_roatation();
+    bullet->speed = 6.0f;
+    bullet->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
+    bullet->gravity_effect = 0.0f;
+    bullet->texture_id = bullet_texture_id;
+    bullet->model_matrix = glm::scale(bullet->model_matrix, glm::vec3(1.0f, 1.0f, 1.0f));
+    bullet->model_matrix = glm::rotate(bullet->model_matrix, bullet->rotation, glm::vec3(0.0f, 0.0f, 1.0f));
+    current_scene->add_bullet(bullet);
+    ammo -= 1;
 }
 
+/**
+ * Reads SDL into live_buttons. Nothing here touches the scene: the buttons are
+ * applied one fixed step at a time in update(), which is also where a replay
+ * swaps in the recorded ones.
+ */
 void process_input()
 {
-    // VERY IMPORTANT: If nothing is pressed, we don't want to go anywhere
-    current_scene->state.player->set_movement(glm::vec3(0.0f));
-    
+    // VERY IMPORTANT: If nothing is held, we don't want to go anywhere.
+    // Presses that no step has seen yet are kept until one does.
+    live_buttons &= INPUT_PRESSES;
+
+    // When idle, sleep here until something happens; the timeout keeps the loop ticking regardless
     SDL_Event event;
-    while (SDL_PollEvent(&event))
+    bool has_event = is_idle() ? SDL_WaitEventTimeout(&event, IDLE_WAIT_MILLISECONDS) : SDL_PollEvent(&event);
+    
+    for (; has_event; has_event = SDL_PollEvent(&event))
     {
+        // Anything from a key press to the window being uncovered may need a fresh frame
+        needs_redraw = true;
+        
         switch (event.type) {
             // End game
             case SDL_QUIT:
             case SDL_WINDOWEVENT_CLOSE:
                 game_is_running = false;
                 break;
-                
+
             case SDL_KEYDOWN:
                 switch (event.key.keysym.sym) {
                     case SDLK_ESCAPE:
                         // Quit the game with a keystroke
                         game_is_running = false;
                         break;
-                        
+
                     case SDLK_SPACE:
                         break;
-                        
+
                     case SDLK_RETURN:
-                        if (current_level_index == 0) {
-                            current_scene->state.next_scene_id = 1;
-                            current_level_index += 1;
-                        }
-                        
+                        live_buttons |= INPUT_ADVANCE;
                         break;
 
                     case SDLK_t:
-                        if (current_scene->state.player->get_active_state() && ammo != 0) {
-                            Mix_PlayChannel(-1, current_scene->state.jump_sfx, 0);
-                            std::cout << "shot!" << std::endl;
-                            Entity* bullet = new Entity();
-                            bullet->set_entity_type(GREEN_LASER);
-                            bullet->set_position(current_scene->state.player->get_position());
-                            bullet->set_movement(glm::vec3(0.0f));
-                            bullet->rotation = current_scene->state.player->get_roatation();
-                            bullet->speed = 6.0f;
-                            bullet->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-                            bullet->gravity_effect = 0.0f;
-                            bullet->texture_id = Utility::load_texture(BULLET_FILEPATH);
-                            bullet->model_matrix = glm::scale(bullet->model_matrix, glm::vec3(1.0f, 1.0f, 1.0f));
-                            bullet->model_matrix = glm::rotate(bullet->model_matrix, bullet->rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-                            current_scene->state.bullet_vector.push_back(bullet);
-                            ammo -= 1;
-                        }
+                        live_buttons |= INPUT_FIRE;
+                        break;
+
+                    case SDLK_F5:
+                        live_buttons |= INPUT_QUICK_SAVE;
+                        break;
+
+                    case SDLK_F8:
+                        live_buttons |= INPUT_RETRY;
+                        break;
+
+                    case SDLK_F9:
+                        live_buttons |= INPUT_QUICK_LOAD;
+                        break;
+
+                    case SDLK_F3:
+                        show_perf_overlay = !show_perf_overlay;
                         break;
 
                     default:
                         break;
                 }
+                break;
 
             case SDL_MOUSEMOTION:
                 // event.motion.x
                 // event.motion.y
                 switch (event.button.button) {
                     case SDL_BUTTON_LEFT:
-                        if (current_scene->state.player->get_active_state() && ammo != 0) {
-                            Mix_PlayChannel(-1, current_scene->state.jump_sfx, 0);
-                            std::cout<<"shot!"<<std::endl;
-                            Entity* bullet = new Entity();
-                            bullet->set_entity_type(GREEN_LASER);
-                            bullet->set_position(current_scene->state.player->get_position());
-                            bullet->set_movement(glm::vec3(0.0f));
-                            bullet->rotation = current_scene->state.player->get_roatation();
-                            bullet->speed = 6.0f;
-                            bullet->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-                            bullet->gravity_effect = 0.0f;
-                            bullet->texture_id = Utility::load_texture(BULLET_FILEPATH);
-                            bullet->model_matrix = glm::scale(bullet->model_matrix, glm::vec3(1.0f, 1.0f, 1.0f));
-                            bullet->model_matrix = glm::rotate(bullet->model_matrix, bullet->rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-                            current_scene->state.bullet_vector.push_back(bullet);
-                            ammo -= 1;
-                            
-                        }
+                        live_buttons |= INPUT_FIRE;
 
                     default:
                         break;
@@ -248,36 +367,102 @@ void process_input()
                 break;
         }
     }
-    
+
     const Uint8* key_state = SDL_GetKeyboardState(NULL);
 
     if (key_state[SDL_SCANCODE_A]) {
-        current_scene->state.player->is_thrusting_left = true;
+        live_buttons |= INPUT_THRUST_LEFT;
     }
     else if (key_state[SDL_SCANCODE_D]) {
-        current_scene->state.player->is_thrusting_right = true;
+        live_buttons |= INPUT_THRUST_RIGHT;
     }
 
     if (key_state[SDL_SCANCODE_W]) {
-        current_scene->state.player->is_thrusting_up = true;
+        live_buttons |= INPUT_THRUST_UP;
     }
     else if (key_state[SDL_SCANCODE_S]) {
-        current_scene->state.player->is_thrusting_down = true;
+        live_buttons |= INPUT_THRUST_DOWN;
     }
 
     if (key_state[SDL_SCANCODE_SPACE]) {
-        current_scene->state.player->is_thrusting_up = true;
+        live_buttons |= INPUT_THRUST_UP;
+    }
+
+    if (key_state[SDL_SCANCODE_R]) {
+        live_buttons |= INPUT_REWIND;
     }
 
     if (key_state[SDL_SCANCODE_Q]) {
-        current_scene->state.player->is_rotating_counter = true;
+        live_buttons |= INPUT_ROTATE_COUNTER;
     }
     else if (key_state[SDL_SCANCODE_E]) {
-        current_scene->state.player->is_rotating_clock = true;
+        live_buttons |= INPUT_ROTATE_CLOCK;
     }
+}
+
+void load_snapshot(const Snapshot &snapshot)
+{
+    if (current_scene->restore_snapshot(snapshot)) ammo = snapshot.get_header()->ammo;
+}
+
+void apply_input(unsigned short buttons)
+{
+    Entity *player = current_scene->state.player;
+    player->set_movement(glm::vec3(0.0f));
 
-    if (glm::length(current_scene->state.player->movement) > 1.0f) {
-        current_scene->state.player->movement = glm::normalize(current_scene->state.player->movement);
+    if ((buttons & INPUT_ADVANCE) && current_level_index == 0) {
+        current_scene->state.next_scene_id = 1;
+        current_level_index += 1;
+    }
+
+    if (buttons & INPUT_FIRE) spawn_bullet();
+
+    if (buttons & INPUT_QUICK_SAVE) {
+        current_scene->save_snapshot(&quick_save);
+        quick_save.get_header()->ammo = ammo;
+        quick_save_scene = current_scene;
+    }
+
+    if ((buttons & INPUT_QUICK_LOAD) && quick_save_scene == current_scene) load_snapshot(quick_save);
+    if (buttons & INPUT_RETRY) load_snapshot(level_start);
+
+    if (buttons & INPUT_THRUST_LEFT)    player->is_thrusting_left = true;
+    if (buttons & INPUT_THRUST_RIGHT)   player->is_thrusting_right = true;
+    if (buttons & INPUT_THRUST_UP)      player->is_thrusting_up = true;
+    if (buttons & INPUT_THRUST_DOWN)    player->is_thrusting_down = true;
+    if (buttons & INPUT_ROTATE_COUNTER) player->is_rotating_counter = true;
+    if (buttons & INPUT_ROTATE_CLOCK)   player->is_rotating_clock = true;
+
+    if (glm::length(player->movement) > 1.0f) {
+        player->movement = glm::normalize(player->movement);
+    }
+}
+
+// One fixed step forward. Where it started from is remembered, so rewinding goes
+// straight back to the step before rather than first to where we already are
+void simulate_step(unsigned short buttons)
+{
+    current_scene->save_snapshot(&rewind_snapshot);
+    rewind_snapshot.get_header()->ammo = ammo;
+    if (!rewind_buffer.push(rewind_snapshot)) {
+        // Skipping it would leave a hole that rewinding jumps straight across, so start over from here
+        if (!rewind_overflowed) {
+            std::cout << "rewind: a " << rewind_snapshot.get_size() << " byte snapshot doesn't fit in "
+                      << rewind_buffer.get_max_snapshot_size() << ", history restarted" << std::endl;
+            rewind_overflowed = true;
+        }
+        rewind_buffer.clear();
+    }
+    
+    // What render() interpolates from
+    Entity::store.save_previous();
+    
+    apply_input(buttons);
+    current_scene->update(FIXED_TIMESTEP);
+
+    // Scene changes happen between steps so a replay switches on the same one
+    if (current_scene->state.next_scene_id >= 0) {
+        switch_to_scene(levels[current_scene->state.next_scene_id]);
     }
 }
 
@@ -286,49 +471,501 @@ void update()
     float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND;
     float delta_time = ticks - previous_ticks;
     previous_ticks = ticks;
-    
+
     delta_time += accumulator;
-    
+
+    // After a stall (loading a scene, a breakpoint...) catching up on every
+    // missed step would only make the next frame late too, so anything past
+    // a few steps' worth is dropped and the game just runs slow for a moment.
+    // A static screen has nothing to catch up on at all after sleeping, and
+    // the scene it hands over to shouldn't start with that backlog either
+    int max_steps = current_scene->is_static() ? 1 : MAX_STEPS_PER_FRAME;
+    if (delta_time > max_steps * FIXED_TIMESTEP) delta_time = max_steps * FIXED_TIMESTEP;
+
     if (delta_time < FIXED_TIMESTEP)
     {
         accumulator = delta_time;
         return;
     }
-    
+
     while (delta_time >= FIXED_TIMESTEP) {
-        current_scene->update(FIXED_TIMESTEP);
-        
+        // Step 1: Work out this step's input, live or from the recording
+        unsigned short buttons = live_buttons;
+        unsigned int expected_hash = 0;
+
+        if (input_recorder.is_replaying() && !input_recorder.next(&buttons, &expected_hash)) {
+            input_recorder.stop();
+            game_is_running = false;
+            break;
+        }
+
+        // Step 2: Simulate, or run time backwards while rewind is held
+        if (buttons & INPUT_REWIND) {
+            if (rewind_buffer.pop(&rewind_snapshot)) load_snapshot(rewind_snapshot);
+        }
+        else {
+            simulate_step(buttons);
+        }
+
+        // Step 3: Remember (or check) where that left us
+        unsigned int state_hash = current_scene->hash_state();
+        input_recorder.record(buttons, state_hash);
+        input_recorder.verify(state_hash, expected_hash);
+
+        // A press only counts for the first step it lands in
+        live_buttons &= ~INPUT_PRESSES;
+
         delta_time -= FIXED_TIMESTEP;
     }
-    
+
     accumulator = delta_time;
+}
+
+void render()
+{
+    // Last frame's text and vertex buffers are done with
+    Utility::frame_arena.reset();
+    
+    // Time left over after the last step: draw everything that far from the previous step to it
+    float alpha = accumulator / FIXED_TIMESTEP;
+    if (alpha > 1.0f) alpha = 1.0f;
     
     // Prevent the camera from showing anything outside of the "edge" of the level
+    glm::vec3 player_position = current_scene->state.player->get_interpolated_position(alpha);
     view_matrix = glm::mat4(1.0f);
-    
-    if (current_scene->state.player->get_position().x > LEVEL1_LEFT_EDGE) {
-        view_matrix = glm::translate(view_matrix, glm::vec3(-current_scene->state.player->get_position().x, 3.75, 0));
+
+    if (player_position.x > LEVEL1_LEFT_EDGE) {
+        view_matrix = glm::translate(view_matrix, glm::vec3(-player_position.x, 3.75, 0));
     } else {
         view_matrix = glm::translate(view_matrix, glm::vec3(-5, 3.75, 0));
     }
-    
+
 
     //view_matrix = glm::translate(view_matrix, glm::vec3(-5, 3.75, 0));
+    
+    render_device->set_view_matrix(&program, view_matrix);
+    
+    render_device->begin_frame();
+    
+    current_scene->render(&program, &render_queue, alpha);
+    
+    if (show_perf_overlay) {
+        // Pinned to the top left of the screen, wherever the camera is
+        glm::vec3 top_left = glm::vec3(-view_matrix[3][0] - 4.8f, -view_matrix[3][1] + 3.55f, 0.0f);
+        PerfStats::draw_overlay(&program, &render_queue, perf_font_texture_id, top_left);
+    }
+    
+    render_queue.submit(render_device);
+    
+    render_device->present();
 }
 
-void render()
+/**
+ * Plays LevelA one step per frame with the ship spinning and firing, and
+ * counts the frames that touch the heap. Loading a scene is allowed to
+ * allocate, so the first ALLOC_CHECK_WARMUP steps after any scene change
+ * don't count. Returns the process exit code.
+ */
+int run_allocation_check(int steps)
 {
-    program.SetViewMatrix(view_matrix);
+    if (!AllocationTracker::is_enabled()) {
+        std::cout << "FAILED: --alloc-check needs a build with TRACK_ALLOCATIONS defined" << std::endl;
+        return 1;
+    }
+
+    current_level_index = 1;
+    switch_to_scene(level_a);
+    ammo = steps;
+
+    // Loading a level always allocates; if none of it was seen, nothing is really being counted
+    int loading_allocations = 0;
+    for (int i = 0; i < AllocationTracker::get_subsystem_count(); i++) {
+        loading_allocations += AllocationTracker::get_total(i).allocations;
+    }
+    if (loading_allocations == 0) {
+        std::cout << "FAILED: no allocations seen while loading LevelA, so the hooks aren't counting" << std::endl;
+        return 1;
+    }
+
+    int allocating_frames = 0;
+    int steps_since_switch = 0;
+
+    for (int step = 0; step < steps; step++) {
+        Scene *scene = current_scene;
+        unsigned short buttons = INPUT_ROTATE_COUNTER;
+        if (step % ALLOC_CHECK_FIRE_EVERY == 0) buttons |= INPUT_FIRE;
+
+        AllocationTracker::begin_frame();
+        {
+            AllocationScope scope("simulation");
+            simulate_step(buttons);
+        }
+        {
+            AllocationScope scope("render");
+            render();
+        }
+        AllocationTracker::end_frame();
+
+        steps_since_switch = current_scene == scene ? steps_since_switch + 1 : 0;
+        if (steps_since_switch <= ALLOC_CHECK_WARMUP) continue;
+
+        if (AllocationTracker::get_frame().allocations > 0) {
+            allocating_frames++;
+            std::cout << "step " << step << " allocated:" << std::endl;
+            AllocationTracker::print_frame(stdout);
+        }
+    }
+
+    std::cout << steps << " steps, " << allocating_frames << " allocating frames" << std::endl;
+    return allocating_frames == 0 ? 0 : 1;
+}
+
+/**
+ * Plays LevelA for RENDER_BUDGET_STEPS steps with the same inputs as
+ * run_allocation_check(), rendering into the null device, and reports the
+ * busiest frame. Returns the process exit code.
+ */
+int run_render_budget(int max_draw_calls)
+{
+    current_level_index = 1;
+    switch_to_scene(level_a);
+    ammo = RENDER_BUDGET_STEPS;
+
+    RenderStats worst = null_device.get_stats();
+    int worst_step = 0;
+
+    for (int step = 0; step < RENDER_BUDGET_STEPS; step++) {
+        unsigned short buttons = INPUT_ROTATE_COUNTER;
+        if (step % ALLOC_CHECK_FIRE_EVERY == 0) buttons |= INPUT_FIRE;
+
+        simulate_step(buttons);
+        render();
+
+        RenderStats stats = null_device.get_stats();
+        if (stats.draw_calls > worst.draw_calls) {
+            worst = stats;
+            worst_step = step;
+        }
+    }
+
+    std::cout << "busiest frame (step " << worst_step << "): "
+              << worst.draw_calls << " draw calls, "
+              << worst.vertices << " vertices, "
+              << worst.state_changes << " state changes, "
+              << worst.texture_binds << " texture binds, "
+              << worst.bytes_uploaded << " bytes" << std::endl;
+
+    return worst.draw_calls <= max_draw_calls ? 0 : 1;
+}
+
+/**
+ * Flies agent_count enemies, a third each of asteroids, aliens and big
+ * aliens, around a field for SWARM_BENCHMARK_STEPS steps, updated the same
+ * way the levels update theirs, and reports how long the steps took.
+ * Passes if the average step fits in FIXED_TIMESTEP. Returns the process
+ * exit code.
+ */
+int run_swarm_benchmark(int agent_count)
+{
+    EntityRegistry registry;
+    ContactList contacts;
+    AIScheduler scheduler;
+    std::vector<Entity*> batch;
+    
+    Entity *player = new Entity();
+    player->set_entity_type(PLAYER);
+    player->set_width(1.0f);
+    player->set_height(1.0f);
+    registry.add(player);
+    
+    // Spread out so each one has about ten others within flocking range
+    float field_size = sqrtf(agent_count * 0.7f);
+    AIType kinds[] = { ASTEROID, ALIEN, BIG_ALIEN };
+    Entity *agents = new Entity[agent_count];
+    srand(1);
+    for (int i = 0; i < agent_count; i++) {
+        float angle = (float) rand() / RAND_MAX * glm::radians(360.0f);
+        agents[i].set_entity_type(ENEMY);
+        agents[i].set_ai_type(kinds[i % 3]);
+        agents[i].set_width(0.5f);
+        agents[i].set_height(0.5f);
+        agents[i].set_position(glm::vec3(((float) rand() / RAND_MAX - 0.5f) * field_size,
+                                          ((float) rand() / RAND_MAX - 0.5f) * field_size, 0.0f));
+        agents[i].set_movement(glm::vec3(cosf(angle), sinf(angle), 0.0f));
+        agents[i].speed = 1.0f;
+        registry.add(&agents[i]);
+    }
+    
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    double total_ms = 0.0, worst_ms = 0.0;
+    
+    for (int step = 0; step < SWARM_BENCHMARK_STEPS; step++) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        
+        contacts.begin_step();
+        scheduler.begin_step();
+        update_entities(&registry, ENEMY, &batch, FIXED_TIMESTEP, player, player, 1, &contacts, &scheduler);
+        
+        double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+        total_ms += ms;
+        if (ms > worst_ms) worst_ms = ms;
+    }
+    
+    double average_ms = total_ms / SWARM_BENCHMARK_STEPS;
+    std::cout << agent_count << " agents, " << SWARM_BENCHMARK_STEPS << " steps: "
+              << average_ms << " ms average, " << worst_ms << " ms worst" << std::endl;
+    
+    delete [] agents;
+    delete player;
+    return average_ms <= FIXED_TIMESTEP * 1000.0 ? 0 : 1;
+}
+
+/**
+ * Builds a map_size x map_size map of PATH_BENCHMARK_ROOM rooms, each with a
+ * doorway in its north and west walls and a scattering of pillars, and times
+ * PATH_BENCHMARK_PATHS paths between random open tiles: plain A* over the
+ * whole map, then the same requests through a PathService. Passes if the
+ * service finds every path plain A* does. Returns the process exit code.
+ */
+int run_path_benchmark(int map_size)
+{
+    std::vector<unsigned int> level_data(map_size * map_size);
+    srand(1);
+    for (int y = 0; y < map_size; y++) {
+        for (int x = 0; x < map_size; x++) {
+            bool is_wall = x % PATH_BENCHMARK_ROOM == 0 || y % PATH_BENCHMARK_ROOM == 0;
+            level_data[y * map_size + x] = is_wall || rand() % 100 < 8 ? 1 : 0;
+        }
+    }
+    for (int y = PATH_BENCHMARK_ROOM; y + PATH_BENCHMARK_ROOM <= map_size; y += PATH_BENCHMARK_ROOM) {
+        for (int x = PATH_BENCHMARK_ROOM; x + PATH_BENCHMARK_ROOM <= map_size; x += PATH_BENCHMARK_ROOM) {
+            int door = 2 + rand() % (PATH_BENCHMARK_ROOM - 4);
+            level_data[y * map_size + x + door] = level_data[y * map_size + x + door + 1] = 0;
+            level_data[(y + door) * map_size + x] = level_data[(y + door + 1) * map_size + x] = 0;
+        }
+    }
+    Map map(map_size, map_size, level_data.data(), 0, 1.0f, 1, 1);
+    
+    std::vector<TilePosition> starts, goals;
+    while ((int) starts.size() < PATH_BENCHMARK_PATHS) {
+        TilePosition start = { rand() % map_size, rand() % map_size }, goal = { rand() % map_size, rand() % map_size };
+        if (!map.is_walkable(start.x, start.y) || !map.is_walkable(goal.x, goal.y)) continue;
+        starts.push_back(start);
+        goals.push_back(goal);
+    }
+    
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 start_time = SDL_GetPerformanceCounter();
+    int worker_count = std::max(1, (int) std::thread::hardware_concurrency() - 1);
+    PathService service(&map, worker_count);
+    double build_ms = (SDL_GetPerformanceCounter() - start_time) * 1000.0 / frequency;
+    
+    // Step 1: Plain A*, one path at a time on this thread
+    ClusterGraph::Search search;
+    std::vector<TilePosition> path;
+    std::vector<bool> is_reachable(PATH_BENCHMARK_PATHS);
+    start_time = SDL_GetPerformanceCounter();
+    for (int i = 0; i < PATH_BENCHMARK_PATHS; i++) {
+        is_reachable[i] = service.get_graph().find_path_flat(starts[i], goals[i], &search, &path);
+    }
+    double flat_us = (SDL_GetPerformanceCounter() - start_time) * 1000000.0 / frequency / PATH_BENCHMARK_PATHS;
+    
+    // Step 2: The same paths, one at a time through the graph...
+    start_time = SDL_GetPerformanceCounter();
+    for (int i = 0; i < PATH_BENCHMARK_PATHS; i++) {
+        service.get_graph().find_path(starts[i], goals[i], &search, &path, PathService::DEFAULT_MAX_EXPANSIONS);
+    }
+    double graph_us = (SDL_GetPerformanceCounter() - start_time) * 1000000.0 / frequency / PATH_BENCHMARK_PATHS;
+    
+    // ...and all at once through the service's workers
+    std::vector<int> tickets;
+    start_time = SDL_GetPerformanceCounter();
+    for (int i = 0; i < PATH_BENCHMARK_PATHS; i++) tickets.push_back(service.request(starts[i], goals[i]));
+    
+    int missed = 0;
+    for (int i = 0; i < PATH_BENCHMARK_PATHS; i++) {
+        PathService::PathStatus status;
+        while ((status = service.collect(tickets[i], &path)) == PathService::PATH_PENDING) std::this_thread::yield();
+        if (is_reachable[i] && status != PathService::PATH_FOUND) missed++;
+    }
+    double service_us = (SDL_GetPerformanceCounter() - start_time) * 1000000.0 / frequency / PATH_BENCHMARK_PATHS;
+    
+    std::cout << map_size << "x" << map_size << " map, " << service.get_graph().get_node_count() << " graph nodes built in "
+              << build_ms << " ms" << std::endl
+              << "per path: " << flat_us << " us flat A*, " << graph_us << " us hierarchical, "
+              << service_us << " us through " << worker_count << " workers, " << missed << " missed" << std::endl;
+    return missed == 0 ? 0 : 1;
+}
+
+/**
+ * Fills a pool of particle_count particles, keeps it full for
+ * PARTICLE_BENCHMARK_STEPS steps and times each step's update plus queueing
+ * and submitting its draw to the null device. Passes if the average step
+ * fits in PARTICLE_BENCHMARK_BUDGET_MS. Returns the process exit code.
+ */
+int run_particle_benchmark(int particle_count)
+{
+    ParticleSystem particles(particle_count, bullet_texture_id);
     
-    glClear(GL_COLOR_BUFFER_BIT);
+    // Lifetimes are cut by up to half, so this outlives the run and nothing dies early
+    float lifetime = PARTICLE_BENCHMARK_STEPS * FIXED_TIMESTEP * 4.0f;
+    particles.emit(glm::vec3(0.0f), particle_count, 3.0f, lifetime, 0.1f);
     
-    current_scene->render(&program);
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    double total_ms = 0.0, worst_ms = 0.0, update_ms = 0.0;
     
-    SDL_GL_SwapWindow(display_window);
+    for (int step = 0; step < PARTICLE_BENCHMARK_STEPS; step++) {
+        // Topped up outside the timing, in case any did go
+        particles.emit(glm::vec3(0.0f), particle_count - particles.get_live_count(), 3.0f, lifetime, 0.1f);
+        
+        Uint64 start = SDL_GetPerformanceCounter();
+        
+        particles.update(FIXED_TIMESTEP);
+        Uint64 updated = SDL_GetPerformanceCounter();
+        
+        null_device.begin_frame();
+        particles.render(&program, &render_queue, 1.0f);
+        render_queue.submit(&null_device);
+        
+        double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+        update_ms += (updated - start) * 1000.0 / frequency;
+        total_ms += ms;
+        if (ms > worst_ms) worst_ms = ms;
+    }
+    
+    double average_ms = total_ms / PARTICLE_BENCHMARK_STEPS;
+    std::cout << particles.get_live_count() << " particles, " << PARTICLE_BENCHMARK_STEPS << " steps: "
+              << average_ms << " ms average (" << update_ms / PARTICLE_BENCHMARK_STEPS << " ms update), "
+              << worst_ms << " ms worst, " << null_device.get_stats().vertices << " vertices drawn" << std::endl;
+    
+    return average_ms <= PARTICLE_BENCHMARK_BUDGET_MS ? 0 : 1;
+}
+
+int sight_check_failures = 0;
+
+void expect_sight(bool is_right, const char *what)
+{
+    if (is_right) return;
+    std::cout << "FAILED: " << what << std::endl;
+    sight_check_failures++;
+}
+
+/**
+ * Builds a SIGHT_CHECK_WIDTH x SIGHT_CHECK_HEIGHT map with a wall down the
+ * middle that stops two rows short of the bottom, and checks lines of sight
+ * across it, straight from Map::raycast() and through a VisibilityCache:
+ * blocked through the wall, clear under it. Then a guard waits on one side
+ * with the player in range on the other, and has to sleep through
+ * SIGHT_CHECK_STEPS steps until a hole is knocked in the wall. Returns the
+ * process exit code.
+ */
+int run_sight_check()
+{
+    // Step 1: The map
+    unsigned int level_data[SIGHT_CHECK_WIDTH * SIGHT_CHECK_HEIGHT] = { 0 };
+    int wall_x = SIGHT_CHECK_WIDTH / 2;
+    for (int y = 0; y < SIGHT_CHECK_HEIGHT - 2; y++) level_data[y * SIGHT_CHECK_WIDTH + wall_x] = 1;
+    Map map(SIGHT_CHECK_WIDTH, SIGHT_CHECK_HEIGHT, level_data, 0, 1.0f, 1, 1);
+    
+    glm::vec3 left  = map.get_tile_centre(wall_x - 2, 1), under_left  = map.get_tile_centre(wall_x - 2, SIGHT_CHECK_HEIGHT - 1);
+    glm::vec3 right = map.get_tile_centre(wall_x + 2, 1), under_right = map.get_tile_centre(wall_x + 2, SIGHT_CHECK_HEIGHT - 1);
+    
+    // Step 2: Raw rays
+    glm::vec3 hit;
+    expect_sight(map.raycast(left, right, &hit), "the wall doesn't block a ray through it");
+    expect_sight(map.get_tile_x(hit.x) == wall_x, "a ray through the wall isn't stopped at the wall");
+    expect_sight(!map.raycast(under_left, under_right), "a ray under the wall is blocked");
+    
+    // Step 3: The same through the cache, asked twice so the second answer is the cached one
+    VisibilityCache visibility;
+    visibility.begin_step(&map, right);
+    expect_sight(!visibility.can_see(left), "the cache sees through the wall");
+    expect_sight(!visibility.can_see(left), "the cache sees through the wall the second time");
+    visibility.begin_step(&map, under_right);
+    expect_sight(visibility.can_see(under_left), "the cache can't see under the wall");
+    
+    // Step 4: A guard behind the wall, in range, sleeps...
+    Entity guard, player;
+    player.set_entity_type(PLAYER);
+    player.set_position(right);
+    guard.set_entity_type(ENEMY);
+    guard.set_ai_type(GUARD);
+    guard.set_ai_state(IDLE);
+    guard.set_position(left);
+    
+    Behaviour behaviour = start_behaviour(GUARD, &guard, &player);
+    for (int step = 0; step < SIGHT_CHECK_STEPS; step++) {
+        visibility.begin_step(&map, player.get_position());
+        behaviour.tick(&guard, &player, FIXED_TIMESTEP, &visibility);
+    }
+    expect_sight(guard.get_ai_state() == IDLE, "a guard woke up through the wall");
+    
+    // ...until it can see the player
+    map.set_tile(wall_x, 1, 0);
+    visibility.begin_step(&map, player.get_position());
+    behaviour.tick(&guard, &player, FIXED_TIMESTEP, &visibility);
+    expect_sight(guard.get_ai_state() != IDLE, "a guard slept on with the wall open");
+    
+    std::cout << "sight check: " << sight_check_failures << " failed" << std::endl;
+    return sight_check_failures == 0 ? 0 : 1;
+}
+
+/**
+ * Records REWIND_SECONDS of entity_count entities into a RewindBuffer the
+ * size the game uses. One in REWIND_CHECK_MOVING_EVERY drifts every step and
+ * the rest stand still, as most of a level does at any moment. Passes if
+ * every step was kept and rewinding all the way comes back to exactly the
+ * first one. Returns the process exit code.
+ */
+int run_rewind_check(int entity_count)
+{
+    int steps = (int) (REWIND_SECONDS / FIXED_TIMESTEP);
+    RewindBuffer buffer(steps, REWIND_STORAGE, Snapshot::size_for(entity_count));
+    Snapshot snapshot, first;
+    
+    // Step 1: A field of entities, laid out on a grid
+    int columns = (int) sqrtf((float) entity_count) + 1;
+    Entity *entities = new Entity[entity_count];
+    srand(1);
+    for (int i = 0; i < entity_count; i++) {
+        float angle = (float) rand() / RAND_MAX * glm::radians(360.0f);
+        entities[i].set_entity_type(ENEMY);
+        entities[i].set_position(glm::vec3((float) (i % columns), (float) (i / columns), 0.0f));
+        if (i % REWIND_CHECK_MOVING_EVERY == 0) entities[i].set_movement(glm::vec3(cosf(angle), sinf(angle), 0.0f));
+    }
+    
+    // Step 2: Record, moving the ones that move the way an update would
+    for (int step = 0; step < steps; step++) {
+        snapshot.resize(entity_count - 1, 0);
+        for (int i = 0; i < entity_count; i++) entities[i].save(&snapshot.get_entities()[i]);
+        if (step == 0) first.load(snapshot.get_data(), snapshot.get_size());
+        buffer.push(snapshot);
+        
+        for (int i = 0; i < entity_count; i += REWIND_CHECK_MOVING_EVERY) {
+            entities[i].set_position(entities[i].get_position() + entities[i].get_movement() * FIXED_TIMESTEP);
+            entities[i].model_matrix = glm::translate(glm::mat4(1.0f), entities[i].get_position());
+        }
+    }
+    
+    int kept = buffer.get_count();
+    size_t used = buffer.get_used_size();
+    std::cout << entity_count << " entities, " << (entity_count + REWIND_CHECK_MOVING_EVERY - 1) / REWIND_CHECK_MOVING_EVERY
+              << " moving: kept " << kept << " of " << steps << " steps in " << used << " of "
+              << buffer.get_storage_size() << " bytes" << std::endl;
+    
+    // Step 3: All the way back
+    while (buffer.pop(&snapshot));
+    bool is_exact = snapshot.get_size() == first.get_size() && memcmp(snapshot.get_data(), first.get_data(), first.get_size()) == 0;
+    if (!is_exact) std::cout << "FAILED: rewinding didn't come back to the first step" << std::endl;
+    
+    delete [] entities;
+    return kept == steps && is_exact ? 0 : 1;
 }
 
 void shutdown()
 {    
+    input_recorder.stop();
+    gl_device.close();
     SDL_Quit();
     
     delete main_menu;
@@ -344,16 +981,94 @@ void shutdown()
  */
 int main(int argc, char* argv[])
 {
-    initialise();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--perf") == 0) show_perf_overlay = true;
+        if (strcmp(argv[i], "--sight-check") == 0) sight_check = true;
+    }
+    
+    // --record <file> saves this session's input, --replay <file> plays one back
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0) input_recorder.start_recording(argv[i + 1]);
+        if (strcmp(argv[i], "--replay") == 0) input_recorder.start_replay(argv[i + 1]);
+        if (strcmp(argv[i], "--alloc-check") == 0) alloc_check_steps = atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--render-budget") == 0) render_budget = atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--swarm-benchmark") == 0) swarm_benchmark = atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--path-benchmark") == 0) path_benchmark = atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--particle-benchmark") == 0) particle_benchmark = atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--rewind-check") == 0) rewind_check = atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--fps") == 0) frame_pacer.set_target_fps((float) atof(argv[i + 1]));
+    }
+    
+    if (!initialise()) {
+        shutdown();
+        return 1;
+    }
+    
+    if (alloc_check_steps > 0) {
+        int result = run_allocation_check(alloc_check_steps);
+        shutdown();
+        return result;
+    }
+    
+    if (render_budget > 0) {
+        int result = run_render_budget(render_budget);
+        shutdown();
+        return result;
+    }
+    
+    if (swarm_benchmark > 0) {
+        int result = run_swarm_benchmark(swarm_benchmark);
+        shutdown();
+        return result;
+    }
+    
+    if (path_benchmark > 0) {
+        int result = run_path_benchmark(path_benchmark);
+        shutdown();
+        return result;
+    }
+    
+    if (particle_benchmark > 0) {
+        int result = run_particle_benchmark(particle_benchmark);
+        shutdown();
+        return result;
+    }
+    
+    if (sight_check) {
+        int result = run_sight_check();
+        shutdown();
+        return result;
+    }
+    
+    if (rewind_check > 0) {
+        int result = run_rewind_check(rewind_check);
+        shutdown();
+        return result;
+    }
     
     while (game_is_running)
     {
-        if (current_scene->state.next_scene_id >= 0) {
-            switch_to_scene(levels[current_scene->state.next_scene_id]);
+        PerfStats::begin_frame();
+        AllocationTracker::begin_frame();
+        {
+            AllocationScope scope("input");
+            process_input();
         }
-        process_input();
-        update();
-        render();
+        {
+            AllocationScope scope("simulation");
+            update();
+        }
+        if (!is_idle() || needs_redraw) {
+            AllocationScope scope("render");
+            render();
+            needs_redraw = false;
+        }
+        AllocationTracker::end_frame();
+        PerfStats::end_frame(render_device->get_stats(), frame_pacer.get_stats());
+        
+        // Idle frames already slept in process_input()
+        if (is_idle()) frame_pacer.restart();
+        else           frame_pacer.wait();
     }
     
     shutdown();
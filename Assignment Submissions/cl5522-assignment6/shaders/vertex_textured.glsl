@@ -1,15 +1,22 @@
 attribute vec4 position;
 attribute vec2 texCoord;
+attribute float spriteIndex;
 
 uniform mat4 modelMatrix;
 uniform mat4 viewMatrix;
 uniform mat4 projectionMatrix;
+uniform vec2 spriteSheet; // (columns, rows) of the bound texture
 
 varying vec2 texCoordVar;
 
 void main()
 {
 	vec4 p = viewMatrix * modelMatrix  * position;
-    texCoordVar = texCoord;
+    
+    // Find which cell of the sheet the frame lives in, then squeeze the quad's 0-1 UVs into it
+    float index = floor(spriteIndex + 0.5);
+    vec2 cell = vec2(mod(index, spriteSheet.x), floor(index / spriteSheet.x));
+    texCoordVar = (cell + texCoord) / spriteSheet;
+    
 	gl_Position = projectionMatrix * p;
-}
\ No newline at end of file
+}